@@ -2,6 +2,12 @@
 
 #include "types.h"
 
+#define MIP_MSIP 0x8   ///< Machine software interrupt pending.
+#define MIP_MTIP 0x80  ///< Machine timer interrupt pending.
+#define MIP_MEIP 0x800 ///< Machine external interrupt pending.
+
+#define MCAUSE_MEI (((word_t)1 << (__riscv_xlen - 1)) | 11) ///< Machine external interrupt cause.
+
 static inline uint64_t csrr_mcycle(void)
 {
 	uint64_t val;
@@ -21,9 +27,52 @@ static inline word_t csrr_mip(void)
 	return val;
 }
 
+static inline word_t csrr_mcause(void)
+{
+	word_t val;
+	__asm__ volatile("csrr %0, mcause" : "=r"(val));
+	return val;
+}
+
 static inline word_t csrr_mhartid(void)
 {
 	word_t val;
 	__asm__ volatile("csrr %0, mhartid" : "=r"(val));
 	return val;
 }
+
+static inline void csrw_pmpcfg0(word_t val)
+{
+	__asm__ volatile("csrw pmpcfg0,%0" ::"r"(val));
+}
+
+static inline void csrw_pmpaddr(pmp_slot_t slot, word_t val)
+{
+	// CSR numbers are immediates, so each PMP address register needs its own instruction.
+	switch (slot) {
+	case 0:
+		__asm__ volatile("csrw pmpaddr0,%0" ::"r"(val));
+		break;
+	case 1:
+		__asm__ volatile("csrw pmpaddr1,%0" ::"r"(val));
+		break;
+	case 2:
+		__asm__ volatile("csrw pmpaddr2,%0" ::"r"(val));
+		break;
+	case 3:
+		__asm__ volatile("csrw pmpaddr3,%0" ::"r"(val));
+		break;
+	case 4:
+		__asm__ volatile("csrw pmpaddr4,%0" ::"r"(val));
+		break;
+	case 5:
+		__asm__ volatile("csrw pmpaddr5,%0" ::"r"(val));
+		break;
+	case 6:
+		__asm__ volatile("csrw pmpaddr6,%0" ::"r"(val));
+		break;
+	case 7:
+		__asm__ volatile("csrw pmpaddr7,%0" ::"r"(val));
+		break;
+	}
+}
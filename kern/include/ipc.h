@@ -1,5 +1,6 @@
 #pragma once
 
+#include "lock.h"
 #include "proc.h"
 #include "types.h"
 
@@ -20,6 +21,23 @@ typedef struct {
 
 _Static_assert(sizeof(ipc_t) == 16, "IPC capability has the wrong size.");
 
+/**
+ * Index in the process state of a process waiting on a set of sinks.
+ */
+#define IPC_INDEX_ANY ((index_t)0xFFFF)
+
+_Static_assert(IPC_TABLE_SIZE < IPC_INDEX_ANY, "IPC table overlaps IPC_INDEX_ANY.");
+
+/**
+ * Maximum number of capabilities transferred by one IPC message.
+ *
+ * A message lists its capabilities as 4-bit types packed in one word, ending
+ * at the first CAPTY_NONE, and their indices packed as index_t values in
+ * another word. A single capability is the type and index in the low bits.
+ * All capabilities are validated before any is transferred.
+ */
+#define IPC_MAX_CAPS (sizeof(word_t) / sizeof(index_t))
+
 void ipc_init();
 
 /**
@@ -103,67 +121,183 @@ int ipc_revoke(pid_t owner, index_t i);
  */
 int ipc_delete(pid_t owner, index_t i);
 
+/**
+ * @brief Binds a memory capability as the message buffer of a sink.
+ *
+ * While a buffer is bound, the two data words of messages sent to or replied
+ * from the sink are an offset and a length, which are checked to lie within
+ * the buffer. Each check uses the memory capability as the sink owner holds it
+ * at that time, and the binding is dropped when the capability is transferred,
+ * revoked or deleted.
+ *
+ * @param owner The owner of the sink and memory capabilities.
+ * @param i The index of the sink capability.
+ * @param j The index of the memory capability.
+ * @param enabled Whether to bind (true) or unbind (false) the buffer.
+ * @return ERR_SUCCESS on success, or an error code on failure.
+ */
+int ipc_bind(pid_t owner, index_t i, index_t j, bool enabled);
+
+/**
+ * @brief Unbinds a memory capability from all sinks using it as message buffer.
+ *
+ * Called when the memory capability changes owner or is removed.
+ *
+ * @param j The index of the memory capability.
+ */
+void ipc_unbind_mem(index_t j);
+
 /**
  * @brief Sends data and a capability to another process.
  * @param owner The owner of the IPC capability.
  * @param i The index of the IPC capability.
  * @param data The data to send.
- * @param capty The type of capability to send.
- * @param j The index of the capability to send.
+ * @param capty The types of the capabilities to send, packed 4 bits each, see IPC_MAX_CAPS.
+ * @param j The indices of the capabilities to send, packed as index_t values.
  * @param next Pointer to store the next process to run.
  * @return ERR_SUCCESS on success, or an error code on failure.
  */
-int ipc_send(pid_t owner, index_t i, word_t data[2], capty_t capty, index_t j, proc_t **next);
+int ipc_send(pid_t owner, index_t i, word_t data[2], word_t capty, word_t j, proc_t **next);
 
 /**
  * @brief Receives data and a capability from another process.
+ *
+ * On an asynchronous sink, a pending message is received without blocking.
+ * Otherwise the process blocks until the next asynchronous send. On a
+ * notification sink, servtime is instead a mask (0 for all bits), and the
+ * process blocks until a bit in the mask is set; those bits are then
+ * cleared and returned.
+ *
  * @param owner The owner of the IPC capability.
  * @param i The index of the IPC capability.
  * @param next Pointer to store the next process to run.
  * @return ERR_SUCCESS on success, or an error code on failure.
  */
-int ipc_recv(pid_t owner, index_t i, proc_t **next, uint32_t servtime);
+int ipc_recv(pid_t owner, index_t i, proc_t **next, uint32_t servtime, uint64_t deadline);
+
+/**
+ * @brief Receives data and a capability on any sink in a set.
+ *
+ * Waits on the sinks `base + k` for each bit `k` set in `mask`. A pending
+ * asynchronous message or notification is received without blocking.
+ * The index of the sink that fired is returned in the a5 register.
+ *
+ * @param owner The owner of the IPC capabilities.
+ * @param base The index of the first sink in the set.
+ * @param mask The bitmask of sinks relative to base.
+ * @param next Pointer to store the next process to run.
+ * @param servtime The service time for the synchronous sinks.
+ * @return ERR_SUCCESS on success, or an error code on failure.
+ */
+int ipc_recv_set(pid_t owner, index_t base, word_t mask, proc_t **next, uint32_t servtime, uint64_t deadline);
 
 /**
  * @brief Calls a function in another process and waits for a reply.
+ *
+ * If the receiver is not waiting and no capability is sent, the caller is
+ * queued on the sink until the receiver calls ipc_recv or ipc_replyrecv.
+ *
  * @param owner The owner of the IPC capability.
  * @param i The index of the IPC capability.
  * @param data The data to send.
- * @param capty The type of capability to send.
- * @param j The index of the capability to send.
+ * @param capty The types of the capabilities to send, packed 4 bits each, see IPC_MAX_CAPS.
+ * @param j The indices of the capabilities to send, packed as index_t values.
  * @param next Pointer to store the next process to run.
  * @return ERR_SUCCESS on success, or an error code on failure.
  */
-int ipc_call(pid_t owner, index_t i, word_t data[2], capty_t capty, index_t j, proc_t **next);
+int ipc_call(pid_t owner, index_t i, word_t data[2], word_t capty, word_t j, proc_t **next, uint64_t deadline);
+
+/**
+ * @brief Gets the locks for the fast path of ipc_call or ipc_replyrecv.
+ *
+ * LOCK_IPC, plus LOCK_MEM if the sink has a bound message buffer. Read
+ * without holding locks; the fast path fails if the buffer changed since.
+ *
+ * @param i The index of the source or sink capability.
+ * @return The locks to take before ipc_call_fast or ipc_replyrecv_fast.
+ */
+lock_set_t ipc_fast_locks(index_t i);
+
+/**
+ * @brief Fast path of ipc_call for yielding calls without capability transfer.
+ *
+ * Applies only if the source capability has the yield flag and the receiver
+ * already waits on the sink. Otherwise nothing is changed and the caller
+ * falls back to ipc_call(), which also reports any error.
+ *
+ * @param owner The owner of the IPC capability.
+ * @param i The index of the IPC capability.
+ * @param data The data to send.
+ * @param next Pointer to store the next process to run.
+ * @param deadline The absolute deadline for the reply, 0 for none.
+ * @param locks The locks held, from ipc_fast_locks().
+ * @return true if the call was performed, false otherwise.
+ */
+bool ipc_call_fast(pid_t owner, index_t i, word_t data[2], proc_t **next, uint64_t deadline, lock_set_t locks);
+
+/**
+ * @brief Cancels the IPC wait of a process whose deadline has passed.
+ *
+ * Called by the scheduler without holding any kernel lock. On success the
+ * process is acquired, and a cancelled call is removed from the caller queue
+ * of its sink and is no longer the call the sink replies to.
+ *
+ * @param pid The process ID of the waiting process.
+ * @return true if the wait was cancelled, false if the process was not blocked on IPC.
+ */
+bool ipc_cancel(pid_t pid);
 
 /**
  * @brief Replies to a received message and sends a capability.
  * @param owner The owner of the IPC capability.
  * @param i The index of the IPC capability.
  * @param data The data to send in the reply.
- * @param capty The type of capability to send.
- * @param j The index of the capability to send.
+ * @param capty The types of the capabilities to send, packed 4 bits each, see IPC_MAX_CAPS.
+ * @param j The indices of the capabilities to send, packed as index_t values.
  * @param next Pointer to store the next process to run.
  * @return ERR_SUCCESS on success, or an error code on failure.
  */
-int ipc_reply(pid_t owner, index_t i, word_t data[2], capty_t capty, index_t j, proc_t **next);
+int ipc_reply(pid_t owner, index_t i, word_t data[2], word_t capty, word_t j, proc_t **next);
 
 /**
  * @brief Replies to a received message and immediately receives another message.
  * @param owner The owner of the IPC capability.
  * @param i The index of the IPC capability.
  * @param data The data to send in the reply.
- * @param capty The type of capability to send.
- * @param j The index of the capability to send.
+ * @param capty The types of the capabilities to send, packed 4 bits each, see IPC_MAX_CAPS.
+ * @param j The indices of the capabilities to send, packed as index_t values.
  * @param next Pointer to store the next process to run.
  * @return ERR_SUCCESS on success, or an error code on failure.
  */
-int ipc_replyrecv(pid_t owner, index_t i, word_t data[2], capty_t capty, index_t j, proc_t **next, uint32_t servtime);
+int ipc_replyrecv(pid_t owner, index_t i, word_t data[2], word_t capty, word_t j, proc_t **next, uint32_t servtime,
+		  uint64_t deadline);
+
+/**
+ * @brief Fast path of ipc_replyrecv for yielding replies without capability transfer.
+ *
+ * Applies only if the sink capability has the yield flag, the client waits
+ * for the reply and no other caller is queued. Otherwise nothing is changed
+ * and the caller falls back to ipc_replyrecv().
+ *
+ * @param owner The owner of the IPC capability.
+ * @param i The index of the IPC capability.
+ * @param data The data to send in the reply.
+ * @param next Pointer to store the next process to run.
+ * @param servtime The service time in microseconds for the next call.
+ * @param deadline The absolute deadline for the next call, 0 for none.
+ * @param locks The locks held, from ipc_fast_locks().
+ * @return true if the reply and receive were performed, false otherwise.
+ */
+bool ipc_replyrecv_fast(pid_t owner, index_t i, word_t data[2], proc_t **next, uint32_t servtime, uint64_t deadline,
+			lock_set_t locks);
 
 /**
  * @brief Asynchronously sends data to another process.
  *
  * This function allows non-blocking communication between processes.
+ * If the receiver is blocked on the sink, it is woken with the data;
+ * otherwise the data is left pending in the sink. On a notification
+ * channel, the data is ORed into the pending bits instead.
  *
  * @param owner The owner of the IPC capability.
  * @param i The index of the IPC capability.
@@ -173,6 +307,29 @@ int ipc_replyrecv(pid_t owner, index_t i, word_t data[2], capty_t capty, index_t
  */
 int ipc_asend(pid_t owner, index_t i, word_t data, proc_t **next);
 
+/**
+ * @brief Checks if a capability is a sink that the kernel can signal.
+ *
+ * @param owner The owner of the capability.
+ * @param i The index of the capability.
+ * @return true if it is an asynchronous or notification sink of the owner.
+ */
+bool ipc_signal_valid(pid_t owner, index_t i);
+
+/**
+ * @brief Signals an asynchronous or notification sink from the kernel.
+ *
+ * Used to deliver events, such as device interrupts, that have no source
+ * capability. The data is posted as by ipc_asend and a waiting receiver
+ * is released.
+ *
+ * @param owner The expected owner of the sink capability.
+ * @param i The index of the sink capability.
+ * @param data The data or notification bits to post.
+ * @return true if the sink is valid and was signalled, false otherwise.
+ */
+bool ipc_signal(pid_t owner, index_t i, word_t data);
+
 /**
  * @brief Asynchronously receives data from another process.
  * @param owner The owner of the IPC capability.
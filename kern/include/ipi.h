@@ -0,0 +1,23 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * @brief Send a machine software interrupt to a hardware thread (hart).
+ *
+ * Memory writes made before the call are visible to the hart when it
+ * takes the interrupt.
+ *
+ * @param hartid ID of the hardware thread.
+ */
+void ipi_send(word_t hartid);
+
+/**
+ * @brief Clear the pending machine software interrupt of a hardware thread (hart).
+ *
+ * Memory reads made after the call observe all writes made before any
+ * interrupt that is cleared.
+ *
+ * @param hartid ID of the hardware thread.
+ */
+void ipi_clear(word_t hartid);
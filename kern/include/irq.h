@@ -0,0 +1,79 @@
+#pragma once
+
+#include "proc.h"
+#include "types.h"
+
+/**
+ * @struct irq
+ * @brief Represents an interrupt capability, one per PLIC interrupt source.
+ */
+typedef struct {
+	pid_t owner;  ///< Process ID of the owner of the capability.
+	bool bound;   ///< Whether the interrupt is bound to a sink.
+	bool masked;  ///< Whether the interrupt is masked until acknowledged.
+	index_t sink; ///< Index of the IPC sink capability signalled.
+	word_t data;  ///< Data or notification bits posted to the sink.
+} irq_t;
+
+/**
+ * Initializes the interrupt capabilities, all owned by the initial process,
+ * and the interrupt controller.
+ */
+void irq_init(void);
+
+/**
+ * Checks if the interrupt capability is valid for the given owner.
+ *
+ * @param owner The owner of the capability.
+ * @param irq The interrupt source number.
+ * @return true if valid, false otherwise.
+ */
+bool irq_valid_access(pid_t owner, index_t irq);
+
+/**
+ * Transfers an interrupt capability to another process.
+ *
+ * The interrupt is unbound and disabled, the new owner binds it again.
+ *
+ * @param owner The current owner of the capability.
+ * @param irq The interrupt source number.
+ * @param new_owner The process ID of the new owner.
+ * @return ERR_SUCCESS on success, ERR_INVALID_ACCESS if not owned by owner.
+ */
+int irq_transfer(pid_t owner, index_t irq, pid_t new_owner);
+
+/**
+ * Binds or unbinds an interrupt to an asynchronous or notification sink.
+ *
+ * When bound, the interrupt is enabled. Each time it fires, the kernel masks
+ * it and posts data to the sink as ipc_asend would, so on a notification
+ * sink data holds the bits to set. The interrupt stays masked until it is
+ * acknowledged with irq_ack.
+ *
+ * @param owner The owner of the interrupt and sink capabilities.
+ * @param irq The interrupt source number.
+ * @param i The index of the sink capability.
+ * @param data The data posted to the sink.
+ * @param enabled Whether to bind (true) or unbind (false) the interrupt.
+ * @return ERR_SUCCESS on success, or an error code on failure.
+ */
+int irq_bind(pid_t owner, index_t irq, index_t i, word_t data, bool enabled);
+
+/**
+ * Acknowledges a signalled interrupt, unmasking it.
+ *
+ * @param owner The owner of the interrupt capability.
+ * @param irq The interrupt source number.
+ * @return ERR_SUCCESS on success, ERR_INVALID_ACCESS if not owned by owner,
+ *         ERR_INVALID_STATE if the interrupt is not bound.
+ */
+int irq_ack(pid_t owner, index_t irq);
+
+/**
+ * Claims and delivers the pending device interrupts of a hart.
+ *
+ * Takes the IPC lock, so the caller must hold no kernel lock.
+ *
+ * @param hart The hart that took the interrupt.
+ */
+void irq_handle(hart_t hart);
@@ -3,16 +3,35 @@
 #include "types.h"
 
 /**
- * Initializes the lock.
+ * Kernel locks, one per capability table.
+ *
+ * A syscall takes the set of locks for the tables it touches, all at once
+ * before doing any work. Locks in a set are acquired in increasing bit order
+ * (mem, tsl, mon, ipc), so two harts never wait on each other in a cycle.
+ * The per-hart scheduler locks are innermost and only taken while holding
+ * LOCK_TSL or no kernel lock at all. Process states are updated atomically
+ * and need no kernel lock.
+ */
+typedef enum lock_set {
+	LOCK_NONE = 0x0, ///< No lock, only checks for preemption.
+	LOCK_MEM = 0x1,	 ///< Lock for the memory capability table.
+	LOCK_TSL = 0x2,	 ///< Lock for the time slice capability table.
+	LOCK_MON = 0x4,	 ///< Lock for the monitor capability table.
+	LOCK_IPC = 0x8,	 ///< Lock for the IPC capability table.
+} lock_set_t;
+
+/**
+ * Initializes the locks.
  */
 void lock_init(void);
 
 /**
- * Acquires the lock.
+ * Acquires a set of locks.
+ * Returns false without holding any lock if preempted while waiting.
  */
-bool lock_acquire(bool preemptable);
+bool lock_acquire(lock_set_t set, bool preemptable);
 
 /**
- * Releases the lock.
+ * Releases a set of locks.
  */
-void lock_release(void);
+void lock_release(lock_set_t set);
@@ -146,3 +146,17 @@ int mon_vreg_get(pid_t owner, index_t i, vreg_t reg, word_t *value);
  * Set the virtual register value for the monitored process.
  */
 int mon_vreg_set(pid_t owner, index_t i, vreg_t reg, word_t value);
+
+/**
+ * Get the accounting figures of the monitored process.
+ *
+ * The figures are updated when the process leaves a hart, so a running
+ * process's current run is not included.
+ *
+ * @param owner The process ID of the owner of the monitor capability.
+ * @param i The index of the monitor capability.
+ * @param stats Pointer to store the figures.
+ * @return ERR_SUCCESS if the figures are retrieved,
+ *         ERR_INVALID_ACCESS if the owner does not match the entry in the monitor table.
+ */
+int mon_stats(pid_t owner, index_t i, proc_stats_t *stats);
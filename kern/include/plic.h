@@ -0,0 +1,35 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * @brief Initialize the platform-level interrupt controller (PLIC).
+ *
+ * Disables all interrupt sources and lets the machine-mode context of
+ * every hart take interrupts of any priority.
+ */
+void plic_init(void);
+
+/**
+ * @brief Enable or disable an interrupt source on all harts.
+ *
+ * @param irq Interrupt source number.
+ * @param enable Whether to enable (true) or disable (false) the source.
+ */
+void plic_enable(word_t irq, bool enable);
+
+/**
+ * @brief Claim the highest priority pending interrupt for a hart.
+ *
+ * @param hartid ID of the hardware thread.
+ * @return The claimed interrupt source number, 0 if none is pending.
+ */
+word_t plic_claim(word_t hartid);
+
+/**
+ * @brief Signal completion of a claimed interrupt.
+ *
+ * @param hartid ID of the hardware thread that claimed the interrupt.
+ * @param irq Interrupt source number.
+ */
+void plic_complete(word_t hartid, word_t irq);
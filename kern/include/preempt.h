@@ -2,12 +2,12 @@
 
 #include "csr.h"
 
-#define CSR_MIP_MTIP (1 << 7)
-
 /**
  * Check if the current hart should preempt.
+ * Besides the timer, wakeups from other harts and device interrupts preempt,
+ * since the process they ready may own the current frame.
  */
 static inline bool preempt(void)
 {
-	return csrr_mip() & CSR_MIP_MTIP;
+	return csrr_mip() & (MIP_MTIP | MIP_MSIP | MIP_MEIP);
 }
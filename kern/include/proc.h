@@ -2,6 +2,19 @@
 
 #include "types.h"
 
+/**
+ * @struct proc_stats
+ * @brief Accounting figures of a process, updated when it leaves a hart.
+ */
+typedef struct proc_stats {
+	uint64_t runtime;   ///< Time in ticks the process has run, including its system calls.
+	uint64_t donated;   ///< Part of runtime on time handed over by another process, e.g., by a yielding IPC call.
+	word_t switches;    ///< Number of times the process was dispatched on a hart.
+	word_t preemptions; ///< Number of times an interrupt took the hart from the process.
+} proc_stats_t;
+
+_Static_assert(sizeof(proc_stats_t) <= 7 * sizeof(word_t), "Process figures do not fit in the result registers.");
+
 /**
  * @struct proc
  * @brief Process control block (PCB) structure.
@@ -22,6 +35,7 @@ typedef struct proc {
 	struct {
 		pmp_addr_t addr[8]; ///< PMP address for each slot.
 		pmp_cfg_t cfg[8];   ///< PMP configuration for each slot.
+		word_t gen;	    ///< Generation, bumped on every change to addr or cfg.
 	} pmp;			    ///< PMP configuration for the process.
 
 	struct {
@@ -32,6 +46,13 @@ typedef struct proc {
 
 	uint64_t timeout; ///< Timeout for the process, used for scheduling.
 	word_t pid;	  ///< Process ID.
+	word_t cont;	  ///< Set if a0-a7 hold a preempted system call, resumed before the process runs.
+
+	struct {
+		uint64_t start;	    ///< Time the process was last dispatched.
+		bool donated;	    ///< If the process runs on time handed over by another process.
+		proc_stats_t stats; ///< Accumulated figures.
+	} acct;
 } __attribute__((aligned(sizeof(word_t)))) proc_t;
 
 typedef enum {
@@ -144,6 +165,17 @@ bool proc_pmp_is_set(pid_t pid, pmp_slot_t slot);
  */
 void proc_pmp_get(pid_t pid, pmp_slot_t slot, mem_perm_t *rwx, pmp_addr_t *addr);
 
+/**
+ * @brief Load a process's PMP configuration into the PMP CSRs.
+ *
+ * Each hart remembers the last PMP image it loaded. If the process and its
+ * PMP generation are unchanged, nothing is written; otherwise only the
+ * entries that differ from the loaded image are rewritten.
+ *
+ * @param proc The process about to be resumed on this hart.
+ */
+void proc_pmp_load(const proc_t *proc);
+
 /**
  * @brief Acquire a process.
  *
@@ -156,6 +188,18 @@ void proc_pmp_get(pid_t pid, pmp_slot_t slot, mem_perm_t *rwx, pmp_addr_t *addr)
  */
 bool proc_acquire(pid_t pid);
 
+/**
+ * @brief Acquire a process to hand it the current hart.
+ *
+ * Like proc_acquire, but fails if the process has a deferred system call
+ * (proc_t.cont is set). Only the scheduler resumes deferred calls, so system
+ * calls that switch directly to another process must use this function.
+ *
+ * @param pid The process ID of the process to acquire.
+ * @return `true` if the process was acquired and can run, `false` otherwise.
+ */
+bool proc_acquire_handoff(pid_t pid);
+
 /**
  * @brief Suspend a process.
  *
@@ -174,6 +218,27 @@ void proc_suspend(pid_t pid);
  */
 void proc_resume(pid_t pid);
 
+/**
+ * @brief Start accounting the run time of a process dispatched on this hart.
+ *
+ * Called from the trap path before the process resumes.
+ *
+ * @param proc The process about to be resumed.
+ * @param donated If the process runs on time handed over by the previous process rather than from the scheduler.
+ */
+void proc_account_start(proc_t *proc, bool donated);
+
+/**
+ * @brief Stop accounting the run time of a process leaving this hart.
+ *
+ * Called from the trap path before the process is released.
+ *
+ * @param proc The process leaving the hart.
+ */
+void proc_account_stop(proc_t *proc);
+
 bool proc_ipc_acquire(pid_t pid, index_t i);
 bool proc_ipc_block(pid_t pid, index_t i);
+bool proc_ipc_blocked_on(pid_t pid, index_t i);
+bool proc_ipc_cancel(pid_t pid, index_t *i);
 void proc_release(pid_t pid);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * Fair queue lock.
+ *
+ * Each hart has a wait slot. A releasing hart hands the lock directly to the
+ * next waiting hart in round-robin order, so a waiter is passed over by at
+ * most _NUM_HARTS - 1 critical sections. A waiter may withdraw from its slot
+ * when preempted, unlike a ticket or MCS lock where a taken ticket or queue
+ * node must be served.
+ */
+typedef struct qlock {
+	volatile word_t held;		  ///< Non-zero if the lock is held.
+	volatile word_t wait[_NUM_HARTS]; ///< Wait state of each hart.
+} qlock_t;
+
+/**
+ * Initialize the queue lock.
+ */
+void qlock_init(qlock_t *qlock);
+
+/**
+ * Acquires the queue lock.
+ */
+bool qlock_acquire(qlock_t *qlock, bool preemptable);
+
+/**
+ * Releases the queue lock, handing it to the next waiting hart.
+ */
+void qlock_release(qlock_t *qlock);
@@ -10,14 +10,15 @@ void sched_init(void);
  *
  * Updates the scheduling table to assign the specified range of slots
  * to the given process. If the current slot falls within the reclaimed
- * range, it updates the current slot to the start of the range.
+ * range of the active mode, it updates the current slot to the start of the range.
  *
  * @param hart The hardware thread ID (hart) to reclaim slots for.
+ * @param mode The schedule mode of the slots.
  * @param pid The process ID to assign the slots to.
  * @param begin The starting index of the slot range.
  * @param end The ending index of the slot range.
  */
-void sched_reclaim(hart_t hart, pid_t pid, time_slot_t begin, time_slot_t end);
+void sched_reclaim(hart_t hart, sched_mode_t mode, pid_t pid, time_slot_t begin, time_slot_t end);
 
 /**
  * @brief Splits a scheduling slot into two parts.
@@ -27,12 +28,13 @@ void sched_reclaim(hart_t hart, pid_t pid, time_slot_t begin, time_slot_t end);
  * Adjusts the current slot if it falls within the second segment.
  *
  * @param hart The hardware thread ID (hart) to split the slot for.
+ * @param mode The schedule mode of the slot.
  * @param pid The process ID of the slot to split.
  * @param begin The starting index of the slot.
  * @param mid The index where the slot is split.
  * @param end The ending index of the slot.
  */
-void sched_split(hart_t hart, pid_t pid, time_slot_t begin, time_slot_t mid, time_slot_t end);
+void sched_split(hart_t hart, sched_mode_t mode, pid_t pid, time_slot_t begin, time_slot_t mid, time_slot_t end);
 
 /**
  * @brief Sets the process ID for a specific scheduling slot.
@@ -41,10 +43,81 @@ void sched_split(hart_t hart, pid_t pid, time_slot_t begin, time_slot_t mid, tim
  * May set pid to INVALID_PID to disable the slot.
  *
  * @param hart The hardware thread ID (hart) to set the slot for.
+ * @param mode The schedule mode of the slot.
  * @param pid The process ID to assign to the slot.
  * @param begin The index of the slot to update.
  */
-void sched_set_pid(hart_t hart, pid_t pid, time_slot_t begin);
+void sched_set_pid(hart_t hart, sched_mode_t mode, pid_t pid, time_slot_t begin);
+
+/**
+ * @brief Sets the slack recipient of a hart.
+ *
+ * The slack recipient runs in the idle remainder of frames in the range
+ * [begin, end) of the given mode whose process is sleeping, blocked or
+ * otherwise not ready. May set pid to INVALID_PID to disable slack donation on the hart.
+ *
+ * @param hart The hardware thread ID (hart) to set the slack recipient for.
+ * @param mode The schedule mode of the donating slots.
+ * @param pid The process ID of the slack recipient.
+ * @param begin The starting index of the donating slot range.
+ * @param end The ending index of the donating slot range.
+ */
+void sched_set_slack(hart_t hart, sched_mode_t mode, pid_t pid, time_slot_t begin, time_slot_t end);
+
+/**
+ * @brief Gets the slack recipient of a hart.
+ *
+ * @param hart The hardware thread ID (hart).
+ * @return The process ID of the slack recipient, INVALID_PID if none.
+ */
+pid_t sched_get_slack(hart_t hart);
+
+/**
+ * @brief Requests a hart to switch schedule mode.
+ *
+ * The hart keeps running its active schedule until the end of the current
+ * major frame and then switches to the requested mode. A later request
+ * before the boundary replaces an earlier one.
+ *
+ * @param hart The hardware thread ID (hart).
+ * @param mode The schedule mode to switch to.
+ */
+void sched_set_mode(hart_t hart, sched_mode_t mode);
+
+/**
+ * @brief Sets the length of a scheduling slot in RTC ticks.
+ *
+ * Frames span whole slots, so slot lengths let frames of very different
+ * lengths share a hart without a fine global slot granularity. The new
+ * length takes effect at the start of the next major frame in the mode.
+ *
+ * @param hart The hardware thread ID (hart).
+ * @param mode The schedule mode of the slot.
+ * @param slot The index of the slot.
+ * @param ticks The length of the slot in RTC ticks.
+ */
+void sched_set_ticks(hart_t hart, sched_mode_t mode, time_slot_t slot, uint32_t ticks);
+
+/**
+ * @brief Gets the active schedule mode of a hart.
+ *
+ * @param hart The hardware thread ID (hart).
+ * @return The active schedule mode.
+ */
+sched_mode_t sched_get_mode(hart_t hart);
+
+/**
+ * @brief Wakes the harts whose current frame belongs to a process.
+ *
+ * Sends a software interrupt to every other hart whose current frame is
+ * owned by the process, so that the hart reschedules immediately. If the
+ * frame of this hart is owned by the process and another process runs in
+ * it, such as the slack recipient, this hart is interrupted as well.
+ * Called after a process is readied from another hart.
+ *
+ * @param pid The process ID of the readied process.
+ */
+void sched_wake(pid_t pid);
 
 /**
  * @brief Main scheduler function to determine the next process to run.
@@ -9,3 +9,25 @@
  * Returns NULL if the scheduler should be invoked.
  */
 proc_t *syscall_handler(void);
+
+/**
+ * Resumes the deferred system call of an acquired process.
+ *
+ * Revocations preempted with children left are deferred: the registers of the
+ * process hold the call and proc_t.cont is set. The scheduler resumes the call
+ * before the process runs, so the process sees one call that completes.
+ *
+ * @param proc The acquired process with proc_t.cont set.
+ * @return true if the call completed, false if it was preempted again.
+ */
+bool syscall_resume(proc_t *proc);
+
+/**
+ * Resumes deferred system calls of processes that are not running.
+ *
+ * Called by idle harts, so pending revocations finish in otherwise unused
+ * time instead of in the time slices of their callers. Stops when preempted.
+ *
+ * @return true if any deferred call completed.
+ */
+bool syscall_resume_deferred(void);
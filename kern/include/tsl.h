@@ -10,14 +10,16 @@
  * the amount of cfree (both remaining and initial), and the time range associated with the capability.
  */
 typedef struct {
-	pid_t owner;	  ///< Process ID of the owner of the capability.
-	fuel_t cfree;	  ///< Remaining free for the capability.
-	fuel_t csize;	  ///< Initial cfree allocated to the capability.
-	hart_t hart;	  ///< The hart of the time slice capability.
-	bool enabled;	  ///< If the time slots are used.
-	time_slot_t base; ///< Start address of the time slots.
-	time_slot_t size; ///< End address of the time slots.
-	time_slot_t free; ///< Start of the allocated region.
+	pid_t owner;	   ///< Process ID of the owner of the capability.
+	fuel_t cfree;	   ///< Remaining free for the capability.
+	fuel_t csize;	   ///< Initial cfree allocated to the capability.
+	hart_t hart;	   ///< The hart of the time slice capability.
+	bool enabled;	   ///< If the time slots are used.
+	time_slot_t base;  ///< Start address of the time slots.
+	time_slot_t size;  ///< End address of the time slots.
+	time_slot_t free;  ///< Start of the allocated region.
+	bool slack;	   ///< If the time slots donate their idle time.
+	sched_mode_t mode; ///< The schedule mode of the time slots.
 } __attribute__((aligned(16))) tsl_t;
 
 void tsl_init();
@@ -114,3 +116,51 @@ int tsl_delete(pid_t owner, index_t i);
  *         ERR_INVALID_ACCESS if the owner does not match the entry in the time table.
  */
 int tsl_set(pid_t owner, index_t i, bool enable);
+
+/**
+ * Donates the idle time of a time slice capability's slots to a process.
+ *
+ * The process runs in the remainder of any frame in the capability's range
+ * whose own process cannot run. Each hart has at most one slack recipient.
+ *
+ * @param owner The process ID associated with the time slice capability.
+ * @param index The index in the time table.
+ * @param pid The process ID of the slack recipient, INVALID_PID to stop donating.
+ * @return ERR_SUCCESS if the slack recipient is successfully set,
+ *         ERR_INVALID_ACCESS if the owner does not match the entry in the time table,
+ *         ERR_SLOT_IN_USE if another capability donates the idle time of the hart.
+ */
+int tsl_slack(pid_t owner, index_t i, pid_t pid);
+
+/**
+ * Switches the hart of a time slice capability to the capability's schedule mode.
+ *
+ * The switch takes effect at the start of the hart's next major frame, so a
+ * hart never runs a mix of two schedules within one major frame. Only a
+ * capability covering the whole major frame of its mode may select it.
+ *
+ * @param owner The process ID associated with the time slice capability.
+ * @param index The index in the time table.
+ * @return ERR_SUCCESS if the mode switch is requested,
+ *         ERR_INVALID_ACCESS if the owner does not match the entry in the time table,
+ *         ERR_INVALID_ARGUMENT if the capability does not cover the whole major frame.
+ */
+int tsl_mode(pid_t owner, index_t i);
+
+/**
+ * Sets the length in RTC ticks of a slot in the schedule mode of a time slice capability.
+ *
+ * The length takes effect at the start of the next major frame in which the
+ * mode is active. Only a capability covering the whole major frame may set
+ * slot lengths, since they move every later frame of the mode.
+ *
+ * @param owner The process ID associated with the time slice capability.
+ * @param index The index in the time table.
+ * @param slot The index of the slot.
+ * @param ticks The length of the slot in RTC ticks, must be non-zero.
+ * @return ERR_SUCCESS if the slot length is set,
+ *         ERR_INVALID_ACCESS if the owner does not match the entry in the time table,
+ *         ERR_INVALID_ARGUMENT if the capability does not cover the whole major frame,
+ *         or the slot or length is out of range.
+ */
+int tsl_ticks(pid_t owner, index_t i, time_slot_t slot, uint32_t ticks);
@@ -14,6 +14,7 @@ typedef uint16_t fuel_t; ///< Fuel type for capabilities.
 
 typedef uint16_t time_slot_t; ///< Slot type for scheduling.
 typedef uint8_t hart_t;	      ///< Hart ID type for hardware threads.
+typedef uint8_t sched_mode_t; ///< Schedule mode type.
 
 typedef uint16_t index_t; ///< Index type for various tables.
 
@@ -75,8 +76,9 @@ enum ipc_mode {
 	IPC_MODE_USYNC = 1,    ///< Unidirectional synchronous IPC.
 	IPC_MODE_BSYNC = 2,    ///< Bidirectional synchronous IPC.
 	IPC_MODE_ASYNC = 3,    ///< Asynchronous IPC.
-	IPC_MODE_MASK = 0x3,   ///< Mask for IPC modes.
-	IPC_MODE_REVOKE = 0x4, ///< Revoke flag for IPC.
+	IPC_MODE_NOTIFY = 4,   ///< Notification bits, accumulated until received.
+	IPC_MODE_MASK = 0x7,   ///< Mask for IPC modes.
+	IPC_MODE_REVOKE = 0x8, ///< Revoke flag for IPC.
 };
 
 typedef uint8_t ipc_mode_t;
@@ -114,13 +116,15 @@ typedef enum capty {
 #define MEM_TABLE_SIZE ((index_t)(MAX_MEMORY_FUEL * _NUM_MEMORY_CAPS)) ///< Maximum memory index.
 #define NUM_MEMORY_CAPS ((index_t)_NUM_MEMORY_CAPS)		       ///< Number of memory capability slots.
 #define MAX_TIME_FUEL ((fuel_t)_MAX_TIME_FUEL)			       ///< Maximum time capabilities.
-#define TSL_TABLE_SIZE ((index_t)(_MAX_TIME_FUEL * _NUM_HARTS))	       ///< Maximum time index.
+#define NUM_SCHED_MODES ((sched_mode_t)_NUM_SCHED_MODES)	       ///< Number of schedule modes per hart.
+#define TSL_TABLE_SIZE ((index_t)(_MAX_TIME_FUEL * _NUM_HARTS * _NUM_SCHED_MODES)) ///< Maximum time index.
 #define MAX_MONITOR_FUEL ((fuel_t)_MAX_MONITOR_FUEL)		       ///< Maximum monitor capabilities.
 #define MON_TABLE_SIZE ((index_t)(MAX_MONITOR_FUEL * MAX_PID))	       ///< Maximum monitor index.
 #define MAX_TIME_SLOT ((time_slot_t)_MAX_TIME_SLOT)		       ///< Maximum time slot constant.
 #define MAX_IPC_FUEL ((fuel_t)_MAX_IPC_FUEL)			       ///< Maximum IPC capabilities.
 #define IPC_TABLE_SIZE ((index_t)(MAX_IPC_FUEL))		       ///< Maximum IPC index.
 #define NUM_HARTS ((hart_t)_NUM_HARTS)				       ///< Number of harts constant.
+#define NUM_IRQ ((index_t)_NUM_IRQ)				       ///< Number of interrupt sources, including source 0.
 #if _NUM_HARTS > 1
 #define SMP
 #endif
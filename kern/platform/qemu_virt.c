@@ -1,5 +1,6 @@
 #include "csr.h"
 #include "ipc.h"
+#include "irq.h"
 #include "lock.h"
 #include "mem.h"
 #include "mon.h"
@@ -30,6 +31,7 @@ void kernel_init(void)
 	tsl_init();
 	mon_init();
 	ipc_init();
+	irq_init();
 	sched_init();
 	lock_init();
 	proc_init(RAM_BASE);
@@ -1,12 +1,19 @@
 #include "interrupt.h"
 
+#include "csr.h"
+#include "irq.h"
+
 /**
- * Dummy interrupt handler.
+ * Interrupt handler for timer, software and external interrupts.
+ * Device interrupts are delivered to their sinks, then all request a reschedule.
+ * The scheduler acknowledges timer and software interrupts.
  */
 proc_t *interrupt_handler(word_t cause, word_t tval)
 {
-	(void)cause;
 	(void)tval;
+	if (cause == MCAUSE_MEI) {
+		irq_handle(csrr_mhartid());
+	}
 	// Returning NULL invokes the scheduler later.
 	return NULL;
 }
@@ -1,11 +1,13 @@
 #include "ipc.h"
 
 #include "current.h"
+#include "lock.h"
 #include "macro.h"
 #include "mem.h"
 #include "mon.h"
 #include "preempt.h"
 #include "rtc.h"
+#include "sched.h"
 #include "tsl.h"
 
 /**
@@ -13,6 +15,22 @@
  */
 static ipc_t ipc_table[IPC_TABLE_SIZE];
 
+/**
+ * Memory capability bound as the message buffer of each sink capability.
+ * Indices are stored as index + 1, so 0 means no buffer is bound.
+ * The base identifies the capability in case its index is reused.
+ */
+static index_t ipc_buf_mem[IPC_TABLE_SIZE];
+static mem_addr_t ipc_buf_base[IPC_TABLE_SIZE];
+
+/**
+ * Queues of callers waiting for a bidirectional sink to receive.
+ * Each queue is a circular list of source indices, linked through ipc_queue_next.
+ * Entries are stored as index + 1, so 0 means empty or not queued.
+ */
+static index_t ipc_queue_tail[IPC_TABLE_SIZE];
+static index_t ipc_queue_next[IPC_TABLE_SIZE];
+
 /**
  * Initialize the IPC capabilities.
  */
@@ -48,6 +66,11 @@ static bool _valid_derivation(ipc_t *cap, fuel_t csize, ipc_mode_t mode, ipc_fla
 		return false;
 	}
 
+	if (mode > IPC_MODE_NOTIFY) {
+		// Not a valid mode.
+		return false;
+	}
+
 	if (cap->mode == IPC_MODE_NONE) {
 		// If deriving a sink IPC capability or NULL IPC capability.
 		return mode != IPC_MODE_NONE || flag == 0;
@@ -56,10 +79,26 @@ static bool _valid_derivation(ipc_t *cap, fuel_t csize, ipc_mode_t mode, ipc_fla
 	return (cap->mode == mode && cap->flag == flag && csize == 1);
 }
 
+/**
+ * Get the type of the k-th capability of a message, packed as 4-bit types.
+ */
+static inline capty_t _capty_at(word_t capty, unsigned k)
+{
+	return (capty >> (4 * k)) & 0xF;
+}
+
+/**
+ * Get the index of the k-th capability of a message, packed as index_t values.
+ */
+static inline index_t _capidx_at(word_t j, unsigned k)
+{
+	return j >> (8 * sizeof(index_t) * k);
+}
+
 /**
  * Check if flags and access rights permit sending a specific capability.
  */
-static bool _valid_capability_send(pid_t owner, index_t i, capty_t capty, ipc_flag_t flag)
+static bool _valid_capability(pid_t owner, index_t i, capty_t capty, ipc_flag_t flag)
 {
 	switch (capty) {
 	case CAPTY_NONE:
@@ -77,6 +116,100 @@ static bool _valid_capability_send(pid_t owner, index_t i, capty_t capty, ipc_fl
 	}
 }
 
+/**
+ * Check if flags and access rights permit sending the capabilities of a message.
+ * The capabilities are listed until the first CAPTY_NONE and must be distinct.
+ */
+static bool _valid_capability_send(pid_t owner, word_t j, word_t capty, ipc_flag_t flag)
+{
+	for (unsigned k = 0; k < IPC_MAX_CAPS; k++) {
+		capty_t ty = _capty_at(capty, k);
+		if (ty == CAPTY_NONE) {
+			// No capabilities may follow the end of the list.
+			return (capty >> (4 * k)) == 0;
+		}
+		index_t i = _capidx_at(j, k);
+		if (!_valid_capability(owner, i, ty, flag)) {
+			return false;
+		}
+		for (unsigned l = 0; l < k; l++) {
+			if (_capty_at(capty, l) == ty && _capidx_at(j, l) == i) {
+				return false;
+			}
+		}
+	}
+	return (capty >> (4 * IPC_MAX_CAPS)) == 0;
+}
+
+/**
+ * Append a source to the caller queue of a sink.
+ */
+static bool _ipc_queue_push(index_t sink, index_t src)
+{
+	// A source is in at most one queue at a time.
+	if (ipc_queue_next[src] != 0) {
+		return false;
+	}
+	index_t tail = ipc_queue_tail[sink];
+	if (tail == 0) {
+		ipc_queue_next[src] = src + 1;
+	} else {
+		ipc_queue_next[src] = ipc_queue_next[tail - 1];
+		ipc_queue_next[tail - 1] = src + 1;
+	}
+	ipc_queue_tail[sink] = src + 1;
+	return true;
+}
+
+/**
+ * Remove the first source from the caller queue of a sink.
+ */
+static bool _ipc_queue_pop(index_t sink, index_t *src)
+{
+	index_t tail = ipc_queue_tail[sink];
+	if (tail == 0) {
+		return false;
+	}
+	index_t head = ipc_queue_next[tail - 1];
+	if (head == tail) {
+		ipc_queue_tail[sink] = 0;
+	} else {
+		ipc_queue_next[tail - 1] = ipc_queue_next[head - 1];
+	}
+	ipc_queue_next[head - 1] = 0;
+	*src = head - 1;
+	return true;
+}
+
+/**
+ * Remove a source from the caller queue of a sink, wherever it is.
+ */
+static void _ipc_queue_remove(index_t sink, index_t src)
+{
+	index_t tail = ipc_queue_tail[sink];
+	if (ipc_queue_next[src] == 0 || tail == 0) {
+		ipc_queue_next[src] = 0;
+		return;
+	}
+	// Find the predecessor of src, bounded by the table size.
+	index_t prev = tail;
+	for (index_t n = 0; n < IPC_TABLE_SIZE && ipc_queue_next[prev - 1] != src + 1; n++) {
+		prev = ipc_queue_next[prev - 1];
+	}
+	if (ipc_queue_next[prev - 1] == src + 1) {
+		if (prev == src + 1) {
+			// The only entry.
+			ipc_queue_tail[sink] = 0;
+		} else {
+			ipc_queue_next[prev - 1] = ipc_queue_next[src];
+			if (tail == src + 1) {
+				ipc_queue_tail[sink] = prev;
+			}
+		}
+	}
+	ipc_queue_next[src] = 0;
+}
+
 /**
  * Transfer an IPC capability from one process to another.
  */
@@ -86,6 +219,8 @@ int ipc_transfer(pid_t owner, index_t i, pid_t new_owner)
 		return ERR_INVALID_ACCESS;
 	}
 	ipc_table[i].owner = new_owner;
+	// The new owner does not hold the bound buffer.
+	ipc_buf_mem[i] = 0;
 	return ERR_SUCCESS;
 }
 
@@ -127,6 +262,12 @@ int ipc_derive(pid_t owner, index_t i, pid_t target, fuel_t csize, ipc_mode_t mo
 	// Calculate the new index for the derived capability.
 	index_t j = i + ipc_table[i].cfree;
 
+	// Drop the slot from any caller queue of its previous capability.
+	index_t stale;
+	_ipc_queue_remove(ipc_table[j].sink, j);
+	while (_ipc_queue_pop(j, &stale))
+		;
+
 	// Add the new IPC capability to the table.
 	ipc_table[j] = (ipc_t){
 		.owner = target,
@@ -138,6 +279,7 @@ int ipc_derive(pid_t owner, index_t i, pid_t target, fuel_t csize, ipc_mode_t mo
 		.source = j,
 		.opt = 0,
 	};
+	ipc_buf_mem[j] = 0;
 
 	// Return the index of the new capability.
 	return j;
@@ -201,10 +343,10 @@ int ipc_delete(pid_t owner, index_t i)
 }
 
 /**
- * Send data and potentially a capability to the receiver.
+ * Send data and potentially capabilities to the receiver.
  * For synchronous IPC only!
  */
-static void do_send(pid_t receiver, word_t data[2], pid_t owner, capty_t capty, index_t i)
+static void do_send(pid_t receiver, word_t data[2], pid_t owner, word_t capty, word_t j)
 {
 	// Send the data to the target process.
 	proc_t *proc = proc_get(receiver);
@@ -213,26 +355,28 @@ static void do_send(pid_t receiver, word_t data[2], pid_t owner, capty_t capty,
 	// Copy data.
 	proc->regs.a1 = data[0];
 	proc->regs.a2 = data[1];
-	// Copy capability information.
+	// Copy capability information, the capabilities were validated together.
 	proc->regs.a3 = capty;
-	proc->regs.a4 = (capty == CAPTY_NONE) ? 0 : i;
-	switch (capty) {
-	case CAPTY_NONE:
-		break;
-	case CAPTY_MEM:
-		mem_transfer(owner, i, receiver);
-		break;
-	case CAPTY_TSL:
-		tsl_transfer(owner, i, receiver);
-		break;
-	case CAPTY_MON:
-		mon_transfer(owner, i, receiver);
-		break;
-	case CAPTY_IPC:
-		ipc_transfer(owner, i, receiver);
-		break;
-	default:
-		__builtin_unreachable();
+	proc->regs.a4 = 0;
+	for (unsigned k = 0; k < IPC_MAX_CAPS && _capty_at(capty, k) != CAPTY_NONE; k++) {
+		index_t i = _capidx_at(j, k);
+		proc->regs.a4 |= (word_t)i << (8 * sizeof(index_t) * k);
+		switch (_capty_at(capty, k)) {
+		case CAPTY_MEM:
+			mem_transfer(owner, i, receiver);
+			break;
+		case CAPTY_TSL:
+			tsl_transfer(owner, i, receiver);
+			break;
+		case CAPTY_MON:
+			mon_transfer(owner, i, receiver);
+			break;
+		case CAPTY_IPC:
+			ipc_transfer(owner, i, receiver);
+			break;
+		default:
+			__builtin_unreachable();
+		}
 	}
 }
 
@@ -253,16 +397,189 @@ static bool _ipc_invoke_valid_access(pid_t owner, index_t i, ipc_mode_t mode, bo
 	return sink ? (ipc_table[i].sink == i) : (ipc_table[i].sink != i);
 }
 
+/**
+ * Get the timeout of a process blocking on IPC, where a deadline of 0 means forever.
+ */
+static inline uint64_t _ipc_deadline(uint64_t deadline)
+{
+	return deadline ? deadline : UINT64_MAX;
+}
+
+/**
+ * Converts a service time in microseconds to RTC ticks, saturating at UINT32_MAX.
+ * Sinks store the service time in ticks so that senders only add and compare.
+ */
+static inline uint32_t _ipc_servtime(uint32_t servtime)
+{
+	if (servtime > UINT32_MAX / TICKS_PER_US) {
+		return UINT32_MAX;
+	}
+	return servtime * TICKS_PER_US;
+}
+
+/**
+ * Check if a message is valid for a sink.
+ * If the sink has a bound buffer, the data is an offset and length within it.
+ */
+static inline bool _valid_message(index_t sink, const word_t data[2])
+{
+	if (ipc_buf_mem[sink] == 0) {
+		return true;
+	}
+
+	// Check against the buffer as the sink owner holds it now.
+	mem_t mem;
+	if (mem_introspect(ipc_table[sink].owner, ipc_buf_mem[sink] - 1, 0, &mem) != ERR_SUCCESS
+	    || mem.base != ipc_buf_base[sink] || (mem.rwx & MEM_PERM_RW) != MEM_PERM_RW) {
+		return false;
+	}
+	return data[0] <= mem.size && data[1] <= mem.size - data[0];
+}
+
+/**
+ * Bind a memory capability as the message buffer of a sink.
+ */
+int ipc_bind(pid_t owner, index_t i, index_t j, bool enabled)
+{
+	if (UNLIKELY(!ipc_valid_access(owner, i))) {
+		return ERR_INVALID_ACCESS;
+	}
+
+	// Only sinks of synchronous channels have message buffers.
+	ipc_mode_t mode = ipc_table[i].mode;
+	if (ipc_table[i].sink != i || (mode != IPC_MODE_USYNC && mode != IPC_MODE_BSYNC)) {
+		return ERR_INVALID_ARGUMENT;
+	}
+
+	if (!enabled) {
+		ipc_buf_mem[i] = 0;
+		return ERR_SUCCESS;
+	}
+
+	// The buffer must be readable and writable by the owner of the sink.
+	mem_t mem;
+	if (mem_introspect(owner, j, 0, &mem) != ERR_SUCCESS) {
+		return ERR_INVALID_ACCESS;
+	}
+	if ((mem.rwx & MEM_PERM_RW) != MEM_PERM_RW) {
+		return ERR_INVALID_ARGUMENT;
+	}
+
+	ipc_buf_mem[i] = j + 1;
+	ipc_buf_base[i] = mem.base;
+	return ERR_SUCCESS;
+}
+
+/**
+ * Unbind a memory capability from every sink using it as message buffer.
+ */
+void ipc_unbind_mem(index_t j)
+{
+	for (index_t i = 0; i < ARRAY_SIZE(ipc_buf_mem); ++i) {
+		if (ipc_buf_mem[i] == j + 1) {
+			ipc_buf_mem[i] = 0;
+		}
+	}
+}
+
+/**
+ * Get the bits a notification receiver waits for, where a mask of 0 means all bits.
+ */
+static inline uint32_t _notify_mask(word_t mask)
+{
+	return mask ? (uint32_t)mask : UINT32_MAX;
+}
+
+/**
+ * Check if an asynchronous or notification sink has a message for a receiver.
+ */
+static inline bool _ipc_async_pending(index_t sink, word_t mask)
+{
+	if (ipc_table[sink].mode == IPC_MODE_NOTIFY) {
+		return (ipc_table[sink].opt & _notify_mask(mask)) != 0;
+	}
+	return ipc_table[sink].source != sink;
+}
+
+/**
+ * Take the message of an asynchronous or notification sink.
+ * Notification bits in the mask are cleared, other bits stay pending.
+ */
+static inline word_t _ipc_async_take(index_t sink, word_t mask)
+{
+	if (ipc_table[sink].mode == IPC_MODE_NOTIFY) {
+		uint32_t bits = ipc_table[sink].opt & _notify_mask(mask);
+		ipc_table[sink].opt &= ~bits;
+		return bits;
+	}
+	ipc_table[sink].source = sink;
+	return ipc_table[sink].opt;
+}
+
+/**
+ * Check if a sink is in the set of sinks a process waits on in ipc_recv_set.
+ * The base and mask of the set stay in the a1 and a2 registers while it waits.
+ */
+static inline bool _ipc_in_set(const proc_t *proc, index_t sink)
+{
+	word_t offset = (word_t)sink - proc->regs.a1;
+	return offset < sizeof(word_t) * 8 && ((proc->regs.a2 >> offset) & 1);
+}
+
+/**
+ * Acquire a receiver waiting on a sink, either on the sink alone or on a set of sinks.
+ * A receiver waiting on a set is told which sink fired in its a5 register.
+ */
+static bool _ipc_acquire_receiver(pid_t receiver, index_t sink)
+{
+	if (proc_ipc_acquire(receiver, sink)) {
+		return true;
+	}
+
+	proc_t *proc = proc_get(receiver);
+	if (!_ipc_in_set(proc, sink) || !proc_ipc_acquire(receiver, IPC_INDEX_ANY)) {
+		return false;
+	}
+	proc->regs.a5 = sink;
+	return true;
+}
+
+/**
+ * Deliver the message of the next queued caller of a sink to its receiver.
+ * Entries whose caller no longer waits on the source are skipped.
+ * The caller stays blocked until it gets a reply.
+ */
+static bool _ipc_dequeue(index_t sink, pid_t receiver)
+{
+	index_t src;
+	while (_ipc_queue_pop(sink, &src)) {
+		pid_t caller = ipc_table[src].owner;
+		if (caller == INVALID_PID || ipc_table[src].sink != sink || ipc_table[src].mode != IPC_MODE_BSYNC
+		    || !proc_ipc_blocked_on(caller, src)) {
+			continue;
+		}
+		// The caller's message is still in its registers.
+		proc_t *proc = proc_get(caller);
+		word_t data[2] = {proc->regs.a2, proc->regs.a3};
+		do_send(receiver, data, caller, CAPTY_NONE, 0);
+		ipc_table[sink].source = src;
+		ipc_table[sink].opt = 0;
+		return true;
+	}
+	return false;
+}
+
 /**
  * Send data and potentially a capability to the receiver.
  * For synchronous unidirectional IPC only!
  */
-int ipc_send(pid_t owner, index_t i, word_t data[2], capty_t capty, index_t j, proc_t **next)
+int ipc_send(pid_t owner, index_t i, word_t data[2], word_t capty, word_t j, proc_t **next)
 {
 	if (UNLIKELY(!_ipc_invoke_valid_access(owner, i, IPC_MODE_USYNC, false))) {
 		return ERR_INVALID_ACCESS;
 	}
-	if (UNLIKELY(!_valid_capability_send(owner, j, capty, ipc_table[i].flag))) {
+	if (UNLIKELY(!_valid_capability_send(owner, j, capty, ipc_table[i].flag)
+		     || !_valid_message(ipc_table[i].sink, data))) {
 		return ERR_INVALID_ARGUMENT;
 	}
 
@@ -282,14 +599,14 @@ int ipc_send(pid_t owner, index_t i, word_t data[2], capty_t capty, index_t j, p
 		// Update the timeout for the call.
 		uint64_t curr_time = rtc_get_time();
 		uint64_t timeout = current->timeout;
-		if (curr_time + ((uint64_t)servtime) * TICKS_PER_US >= timeout) {
+		if (curr_time + servtime >= timeout) {
 			// If the service time exceeds the current timeout, return timeout error.
 			return ERR_INVALID_STATE;
 		}
 	}
 
 	// Check if the receiver is ready.
-	if (!proc_ipc_acquire(receiver, sink)) {
+	if (!_ipc_acquire_receiver(receiver, sink)) {
 		return ERR_INVALID_STATE;
 	}
 
@@ -306,6 +623,7 @@ int ipc_send(pid_t owner, index_t i, word_t data[2], capty_t capty, index_t j, p
 	} else {
 		// If not yielding IPC, release the receiver.
 		proc_release(receiver);
+		sched_wake(receiver);
 	}
 	return ERR_SUCCESS;
 }
@@ -314,18 +632,91 @@ int ipc_send(pid_t owner, index_t i, word_t data[2], capty_t capty, index_t j, p
  * Receive data and potentially a capability from the sender.
  * For synchronous IPC only!
  */
-int ipc_recv(pid_t owner, index_t i, proc_t **next, uint32_t servtime)
+int ipc_recv(pid_t owner, index_t i, proc_t **next, uint32_t servtime, uint64_t deadline)
 {
 	if (!_ipc_invoke_valid_access(owner, i, IPC_MODE_USYNC, true)
-	    && _ipc_invoke_valid_access(owner, i, IPC_MODE_BSYNC, true)) {
+	    && !_ipc_invoke_valid_access(owner, i, IPC_MODE_BSYNC, true)
+	    && !_ipc_invoke_valid_access(owner, i, IPC_MODE_ASYNC, true)
+	    && !_ipc_invoke_valid_access(owner, i, IPC_MODE_NOTIFY, true)) {
 		return ERR_INVALID_ACCESS;
 	}
+
+	if (ipc_table[i].mode == IPC_MODE_ASYNC || ipc_table[i].mode == IPC_MODE_NOTIFY) {
+		// For notifications, servtime is the mask of bits to wait for.
+		if (_ipc_async_pending(i, servtime)) {
+			// Receive the pending message without blocking.
+			word_t data[2] = {_ipc_async_take(i, servtime), 0};
+			do_send(owner, data, owner, CAPTY_NONE, 0);
+			return ERR_SUCCESS;
+		}
+		// Wait for the next message, the mask stays in the a2 register.
+		proc_ipc_block(owner, i);
+		(*next)->timeout = _ipc_deadline(deadline);
+		*next = NULL;
+		return ERR_SUCCESS;
+	}
+	// Take a queued caller without blocking.
+	if (ipc_table[i].mode == IPC_MODE_BSYNC && _ipc_dequeue(i, owner)) {
+		return ERR_SUCCESS;
+	}
+
 	// Go to a receiver state.
 	proc_ipc_block(owner, i);
 	ipc_table[i].source = i;
-	ipc_table[i].opt = servtime;
+	ipc_table[i].opt = _ipc_servtime(servtime);
 
-	(*next)->timeout = UINT64_MAX;
+	(*next)->timeout = _ipc_deadline(deadline);
+	*next = NULL;
+	return ERR_SUCCESS;
+}
+
+/**
+ * Receive data and potentially a capability on any sink in a set.
+ */
+int ipc_recv_set(pid_t owner, index_t base, word_t mask, proc_t **next, uint32_t servtime, uint64_t deadline)
+{
+	if (mask == 0) {
+		return ERR_INVALID_ARGUMENT;
+	}
+
+	// All capabilities in the set must be sinks owned by the caller.
+	for (word_t set = mask; set != 0; set &= set - 1) {
+		index_t i = base + __builtin_ctzl(set);
+		if (i < base || !ipc_valid_access(owner, i) || ipc_table[i].sink != i
+		    || ipc_table[i].mode == IPC_MODE_NONE) {
+			return ERR_INVALID_ACCESS;
+		}
+	}
+
+	// Receive a pending asynchronous message, notification or queued call without blocking.
+	for (word_t set = mask; set != 0; set &= set - 1) {
+		index_t i = base + __builtin_ctzl(set);
+		ipc_mode_t mode = ipc_table[i].mode;
+		if ((mode == IPC_MODE_ASYNC || mode == IPC_MODE_NOTIFY) && _ipc_async_pending(i, 0)) {
+			word_t data[2] = {_ipc_async_take(i, 0), 0};
+			do_send(owner, data, owner, CAPTY_NONE, 0);
+			proc_get(owner)->regs.a5 = i;
+			return ERR_SUCCESS;
+		}
+		if (mode == IPC_MODE_BSYNC && _ipc_dequeue(i, owner)) {
+			proc_get(owner)->regs.a5 = i;
+			return ERR_SUCCESS;
+		}
+	}
+
+	// Prepare the synchronous sinks for receiving.
+	for (word_t set = mask; set != 0; set &= set - 1) {
+		index_t i = base + __builtin_ctzl(set);
+		ipc_mode_t mode = ipc_table[i].mode;
+		if (mode == IPC_MODE_USYNC || mode == IPC_MODE_BSYNC) {
+			ipc_table[i].source = i;
+			ipc_table[i].opt = _ipc_servtime(servtime);
+		}
+	}
+
+	// Wait on all sinks in the set.
+	proc_ipc_block(owner, IPC_INDEX_ANY);
+	(*next)->timeout = _ipc_deadline(deadline);
 	*next = NULL;
 	return ERR_SUCCESS;
 }
@@ -333,12 +724,12 @@ int ipc_recv(pid_t owner, index_t i, proc_t **next, uint32_t servtime)
 /**
  * Send a synchronous IPC call to the receiver.
  */
-int ipc_call(pid_t owner, index_t i, word_t data[2], capty_t capty, index_t j, proc_t **next)
+int ipc_call(pid_t owner, index_t i, word_t data[2], word_t capty, word_t j, proc_t **next, uint64_t deadline)
 {
 	if (!_ipc_invoke_valid_access(owner, i, IPC_MODE_BSYNC, false)) {
 		return ERR_INVALID_ACCESS;
 	}
-	if (!_valid_capability_send(owner, j, capty, ipc_table[i].flag)) {
+	if (!_valid_capability_send(owner, j, capty, ipc_table[i].flag) || !_valid_message(ipc_table[i].sink, data)) {
 		return ERR_INVALID_ARGUMENT;
 	}
 	// Get the sink capability and receiver process.
@@ -356,15 +747,25 @@ int ipc_call(pid_t owner, index_t i, word_t data[2], capty_t capty, index_t j, p
 		// Update the timeout for the call.
 		uint64_t curr_time = rtc_get_time();
 		uint64_t timeout = current->timeout;
-		if (curr_time + ((uint64_t)servtime) * TICKS_PER_US >= timeout) {
+		if (curr_time + servtime >= timeout) {
 			// If the service time exceeds the current timeout, return timeout error.
 			return ERR_INVALID_STATE;
 		}
 	}
 
-	// If receiver is invalid or not ready, return invalid state error.
-	if (!proc_ipc_acquire(receiver, sink)) {
-		return ERR_INVALID_STATE;
+	if (!_ipc_acquire_receiver(receiver, sink)) {
+		// Capabilities are only sent to a waiting receiver.
+		if (capty != CAPTY_NONE) {
+			return ERR_INVALID_STATE;
+		}
+		// Queue the caller until the receiver takes the call.
+		if (!_ipc_queue_push(sink, i)) {
+			return ERR_INVALID_STATE;
+		}
+		proc_ipc_block(owner, i);
+		(*next)->timeout = _ipc_deadline(deadline);
+		*next = NULL;
+		return ERR_TIMEOUT;
 	}
 
 	// Perform the send operation.
@@ -386,20 +787,109 @@ int ipc_call(pid_t owner, index_t i, word_t data[2], capty_t capty, index_t j, p
 	} else {
 		// Release the receiver.
 		proc_release(receiver);
-		sender->timeout = UINT64_MAX;
+		sched_wake(receiver);
 	}
+	sender->timeout = _ipc_deadline(deadline);
 	return ERR_TIMEOUT;
 }
 
+/**
+ * Get the locks taken by the fast path of a call or reply-receive on capability i.
+ * Read without locks, the fast path fails if a buffer was bound since.
+ */
+lock_set_t ipc_fast_locks(index_t i)
+{
+	if (i >= IPC_TABLE_SIZE || ipc_table[i].sink >= IPC_TABLE_SIZE) {
+		return LOCK_IPC;
+	}
+	return ipc_buf_mem[ipc_table[i].sink] != 0 ? (LOCK_MEM | LOCK_IPC) : LOCK_IPC;
+}
+
+/**
+ * Check that a message to a sink can be validated with the locks held.
+ */
+static inline bool _ipc_fast_message(index_t sink, const word_t data[2], lock_set_t locks)
+{
+	if (ipc_buf_mem[sink] != 0 && !(locks & LOCK_MEM)) {
+		return false;
+	}
+	return _valid_message(sink, data);
+}
+
+/**
+ * Fast path of ipc_call for a yielding call without capability transfer
+ * to a receiver that is already waiting on the sink.
+ */
+bool ipc_call_fast(pid_t owner, index_t i, word_t data[2], proc_t **next, uint64_t deadline, lock_set_t locks)
+{
+	if (!_ipc_invoke_valid_access(owner, i, IPC_MODE_BSYNC, false) || !(ipc_table[i].flag & IPC_FLAG_YIELD)) {
+		return false;
+	}
+	index_t sink = ipc_table[i].sink;
+	pid_t receiver = ipc_table[sink].owner;
+	if (receiver == INVALID_PID || !_ipc_fast_message(sink, data, locks)) {
+		return false;
+	}
+
+	// The receiver must be able to serve the call within the sender's time.
+	proc_t *sender = *next;
+	if ((ipc_table[sink].flag & IPC_FLAG_YIELD) && rtc_get_time() + ipc_table[sink].opt >= sender->timeout) {
+		return false;
+	}
+	if (!proc_ipc_acquire(receiver, sink)) {
+		return false;
+	}
+
+	do_send(receiver, data, owner, CAPTY_NONE, 0);
+	ipc_table[sink].source = i;
+	ipc_table[sink].opt = 0;
+
+	// Wait for the reply and switch directly to the receiver.
+	proc_ipc_block(owner, i);
+	*next = proc_get(receiver);
+	(*next)->timeout = sender->timeout;
+	sender->timeout = _ipc_deadline(deadline);
+	return true;
+}
+
+/**
+ * Cancel the IPC wait of a process whose deadline has passed, acquiring it.
+ * A cancelled call is withdrawn from the caller queue and from the sink serving it.
+ */
+bool ipc_cancel(pid_t pid)
+{
+	index_t i;
+	if (!proc_ipc_cancel(pid, &i)) {
+		return false;
+	}
+
+	// A process waiting on a set of sinks (IPC_INDEX_ANY) is in no caller queue.
+	if (i >= IPC_TABLE_SIZE) {
+		return true;
+	}
+
+	// The process is acquired, so it cannot use the source again until we are done.
+	lock_acquire(LOCK_IPC, false);
+	index_t sink = ipc_table[i].sink;
+	if (ipc_table[i].mode == IPC_MODE_BSYNC && sink != i) {
+		_ipc_queue_remove(sink, i);
+		if (ipc_table[sink].source == i) {
+			ipc_table[sink].source = sink;
+		}
+	}
+	lock_release(LOCK_IPC);
+	return true;
+}
+
 /**
  * Reply to a synchronous IPC call.
  */
-int ipc_reply(pid_t owner, index_t i, word_t data[2], capty_t capty, index_t j, proc_t **next)
+int ipc_reply(pid_t owner, index_t i, word_t data[2], word_t capty, word_t j, proc_t **next)
 {
 	if (!_ipc_invoke_valid_access(owner, i, IPC_MODE_BSYNC, true)) {
 		return ERR_INVALID_ACCESS;
 	}
-	if (!_valid_capability_send(owner, j, capty, ipc_table[i].flag)) {
+	if (!_valid_capability_send(owner, j, capty, ipc_table[i].flag) || !_valid_message(i, data)) {
 		return ERR_INVALID_ARGUMENT;
 	}
 	// Get the source capability and client process.
@@ -426,8 +916,9 @@ int ipc_reply(pid_t owner, index_t i, word_t data[2], capty_t capty, index_t j,
 	} else {
 		// If not yielding IPC, release the receiver.
 		// Set timeout to 0 so it can be scheduled as soon as possible.
-		proc_release(receiver_pid);
 		receiver->timeout = 0;
+		proc_release(receiver_pid);
+		sched_wake(receiver_pid);
 	}
 	return ERR_SUCCESS;
 }
@@ -435,13 +926,14 @@ int ipc_reply(pid_t owner, index_t i, word_t data[2], capty_t capty, index_t j,
 /**
  * Reply and receive in a single IPC operation.
  */
-int ipc_replyrecv(pid_t owner, index_t i, word_t data[2], capty_t capty, index_t j, proc_t **next, uint32_t servtime)
+int ipc_replyrecv(pid_t owner, index_t i, word_t data[2], word_t capty, word_t j, proc_t **next, uint32_t servtime,
+		  uint64_t deadline)
 {
 	if (!_ipc_invoke_valid_access(owner, i, IPC_MODE_BSYNC, true)) {
 		return ERR_INVALID_ACCESS;
 	}
 
-	if (!_valid_capability_send(owner, j, capty, ipc_table[i].flag)) {
+	if (!_valid_capability_send(owner, j, capty, ipc_table[i].flag) || !_valid_message(i, data)) {
 		return ERR_INVALID_ARGUMENT;
 	}
 
@@ -453,14 +945,27 @@ int ipc_replyrecv(pid_t owner, index_t i, word_t data[2], capty_t capty, index_t
 	// Get the source and sink capabilities.
 	index_t source = ipc_table[i].source;
 	pid_t recv_pid = ipc_table[source].owner;
+	proc_t *receiver = NULL;
 
 	if ((source != i) && (recv_pid != INVALID_PID) && proc_ipc_acquire(recv_pid, source)) {
 		// Do send operation.
 		do_send(recv_pid, data, owner, capty, j);
 		ipc_table[i].source = i; // Clear the source capability.
+		receiver = proc_get(recv_pid);
+	}
 
-		proc_t *receiver = proc_get(recv_pid);
+	// Take a queued caller instead of waiting, the receiver of the reply runs later.
+	if (_ipc_dequeue(i, owner)) {
+		if (receiver) {
+			receiver->timeout = 0;
+			proc_release(recv_pid);
+			sched_wake(recv_pid);
+		}
+		*next = sender;
+		return ERR_SUCCESS;
+	}
 
+	if (receiver) {
 		if (ipc_table[i].flag & IPC_FLAG_YIELD) {
 			// If yielding IPC, set the next process to the receiver.
 			*next = receiver;
@@ -468,54 +973,158 @@ int ipc_replyrecv(pid_t owner, index_t i, word_t data[2], capty_t capty, index_t
 			receiver->timeout = sender->timeout;
 		} else {
 			// If not yielding IPC, release the receiver.
-			proc_release(recv_pid);
 			// Set timeout to 0 so it can be scheduled as soon as possible.
 			receiver->timeout = 0;
+			proc_release(recv_pid);
+			sched_wake(recv_pid);
 		}
 	}
 
 	// Perform receive operation.
 	proc_ipc_block(owner, i);
-	ipc_table[i].opt = servtime; // Store service time in opt field.
-	sender->timeout = UINT64_MAX;
+	ipc_table[i].opt = _ipc_servtime(servtime); // Store service time in ticks in opt field.
+	sender->timeout = _ipc_deadline(deadline);
 
 	return ERR_SUCCESS;
 }
 
+/**
+ * Fast path of ipc_replyrecv for a yielding reply without capability transfer
+ * to a client that waits for it, when no other caller is queued.
+ */
+bool ipc_replyrecv_fast(pid_t owner, index_t i, word_t data[2], proc_t **next, uint32_t servtime, uint64_t deadline,
+			lock_set_t locks)
+{
+	if (!_ipc_invoke_valid_access(owner, i, IPC_MODE_BSYNC, true) || !(ipc_table[i].flag & IPC_FLAG_YIELD)
+	    || ipc_queue_tail[i] != 0 || !_ipc_fast_message(i, data, locks)) {
+		return false;
+	}
+	index_t source = ipc_table[i].source;
+	pid_t client = ipc_table[source].owner;
+	if (source == i || client == INVALID_PID || !proc_ipc_acquire(client, source)) {
+		return false;
+	}
+
+	do_send(client, data, owner, CAPTY_NONE, 0);
+	ipc_table[i].source = i;
+
+	// Wait for the next call and switch directly to the client.
+	proc_t *server = *next;
+	*next = proc_get(client);
+	(*next)->timeout = server->timeout;
+	proc_ipc_block(owner, i);
+	ipc_table[i].opt = _ipc_servtime(servtime);
+	server->timeout = _ipc_deadline(deadline);
+	return true;
+}
+
+/**
+ * Post a message to an asynchronous or notification sink from a source.
+ * If the owner of the sink waits for the message, it is acquired and the message is delivered.
+ * Returns the PID of the acquired receiver, or INVALID_PID if the message stays pending.
+ */
+static pid_t _ipc_async_post(index_t sink, index_t src, word_t data)
+{
+	pid_t recv_pid = ipc_table[sink].owner;
+
+	if (ipc_table[sink].mode == IPC_MODE_NOTIFY) {
+		// Notification bits accumulate in the opt field.
+		ipc_table[sink].opt |= data;
+	} else {
+		// Data stored in the opt field, marked as pending.
+		ipc_table[sink].opt = data;
+		ipc_table[sink].source = src;
+	}
+
+	if (recv_pid == INVALID_PID) {
+		return INVALID_PID;
+	}
+
+	// If the receiver waits on this sink alone, its a2 register holds the notification mask.
+	proc_t *receiver = proc_get(recv_pid);
+	word_t mask = proc_ipc_blocked_on(recv_pid, sink) ? receiver->regs.a2 : 0;
+	if (!_ipc_async_pending(sink, mask) || !_ipc_acquire_receiver(recv_pid, sink)) {
+		return INVALID_PID;
+	}
+	// Wake the receiver with the message.
+	word_t msg[2] = {_ipc_async_take(sink, mask), 0};
+	do_send(recv_pid, msg, INVALID_PID, CAPTY_NONE, 0);
+	return recv_pid;
+}
+
 /**
  * Asynchronously send data.
  */
 int ipc_asend(pid_t owner, index_t i, word_t data, proc_t **next)
 {
-	if (!_ipc_invoke_valid_access(owner, i, IPC_MODE_ASYNC, false)) {
+	bool notify = _ipc_invoke_valid_access(owner, i, IPC_MODE_NOTIFY, false);
+	if (!notify && !_ipc_invoke_valid_access(owner, i, IPC_MODE_ASYNC, false)) {
 		return ERR_INVALID_ACCESS;
 	}
 
 	index_t sink = ipc_table[i].sink;
-	pid_t recv_pid = ipc_table[sink].owner;
-
-	// Data stored in the opt field.
-	ipc_table[sink].source = i;
-	ipc_table[sink].opt = data;
+	pid_t recv_pid = _ipc_async_post(sink, i, data);
+	proc_t *sender = *next;
 
-	if ((ipc_table[i].flag & IPC_FLAG_YIELD) && recv_pid != INVALID_PID && proc_acquire(recv_pid)) {
-		proc_t *sender = *next;
+	if (recv_pid != INVALID_PID) {
 		proc_t *receiver = proc_get(recv_pid);
-		*next = receiver;
-		receiver->timeout = sender->timeout;
+		if (ipc_table[i].flag & IPC_FLAG_YIELD) {
+			*next = receiver;
+			receiver->timeout = sender->timeout;
+		} else {
+			// Set timeout to 0 so it can be scheduled as soon as possible.
+			receiver->timeout = 0;
+			proc_release(recv_pid);
+			sched_wake(recv_pid);
+		}
+		return ERR_SUCCESS;
+	}
+
+	recv_pid = ipc_table[sink].owner;
+	if (recv_pid != INVALID_PID && (ipc_table[i].flag & IPC_FLAG_YIELD) && proc_acquire_handoff(recv_pid)) {
+		*next = proc_get(recv_pid);
+		(*next)->timeout = sender->timeout;
 	}
 	return ERR_SUCCESS;
 }
 
+/**
+ * Check if a capability is an asynchronous or notification sink the kernel can signal.
+ */
+bool ipc_signal_valid(pid_t owner, index_t i)
+{
+	return _ipc_invoke_valid_access(owner, i, IPC_MODE_NOTIFY, true)
+	       || _ipc_invoke_valid_access(owner, i, IPC_MODE_ASYNC, true);
+}
+
+/**
+ * Signal an asynchronous or notification sink from the kernel.
+ */
+bool ipc_signal(pid_t owner, index_t i, word_t data)
+{
+	if (!ipc_signal_valid(owner, i)) {
+		return false;
+	}
+	// There is no source capability, IPC_INDEX_ANY marks the message as pending.
+	pid_t recv_pid = _ipc_async_post(i, IPC_INDEX_ANY, data);
+	if (recv_pid != INVALID_PID) {
+		proc_get(recv_pid)->timeout = 0;
+		proc_release(recv_pid);
+		sched_wake(recv_pid);
+	}
+	return true;
+}
+
 /**
  * Asynchronously receive data.
  */
 int ipc_arecv(pid_t owner, index_t i, word_t *data)
 {
-	if (!_ipc_invoke_valid_access(owner, i, IPC_MODE_ASYNC, true)) {
+	if (!_ipc_invoke_valid_access(owner, i, IPC_MODE_ASYNC, true)
+	    && !_ipc_invoke_valid_access(owner, i, IPC_MODE_NOTIFY, true)) {
 		return ERR_INVALID_ACCESS;
 	}
-	// Read data from the opt field.
-	*data = ipc_table[i].opt;
+	// Read data from the opt field, taking all notification bits.
+	*data = _ipc_async_take(i, 0);
 	return ERR_SUCCESS;
 }
@@ -0,0 +1,26 @@
+#include "ipi.h"
+
+// External variable for the machine software interrupt pending registers.
+extern volatile uint32_t __msip[];
+
+/**
+ * @brief Send a machine software interrupt to a hart.
+ * @param hartid ID of the hardware thread.
+ */
+void ipi_send(word_t hartid)
+{
+	// Order earlier memory writes before the device write.
+	__asm__ volatile("fence rw,o" ::: "memory");
+	__msip[hartid] = 1;
+}
+
+/**
+ * @brief Clear the machine software interrupt of a hart.
+ * @param hartid ID of the hardware thread.
+ */
+void ipi_clear(word_t hartid)
+{
+	__msip[hartid] = 0;
+	// Order the device write before later memory reads.
+	__asm__ volatile("fence o,rw" ::: "memory");
+}
@@ -0,0 +1,107 @@
+#include "irq.h"
+
+#include "ipc.h"
+#include "lock.h"
+#include "macro.h"
+#include "plic.h"
+
+/**
+ * Interrupt capabilities, indexed by PLIC source number. Source 0 does not exist.
+ * Protected by the IPC lock, since interrupts are delivered through IPC sinks.
+ */
+static irq_t irq_table[NUM_IRQ];
+
+/**
+ * Initializes the interrupt capabilities.
+ */
+void irq_init(void)
+{
+	for (index_t irq = 1; irq < NUM_IRQ; irq++) {
+		irq_table[irq] = (irq_t){.owner = 1};
+	}
+	plic_init();
+}
+
+/**
+ * Checks if the interrupt capability is valid for the given owner.
+ */
+bool irq_valid_access(pid_t owner, index_t irq)
+{
+	return irq < ARRAY_SIZE(irq_table) && irq_table[irq].owner == owner && owner != INVALID_PID;
+}
+
+/**
+ * Transfers an interrupt capability to a new owner.
+ */
+int irq_transfer(pid_t owner, index_t irq, pid_t new_owner)
+{
+	if (!irq_valid_access(owner, irq)) {
+		return ERR_INVALID_ACCESS;
+	}
+	plic_enable(irq, false);
+	irq_table[irq] = (irq_t){.owner = new_owner};
+	return ERR_SUCCESS;
+}
+
+/**
+ * Binds or unbinds an interrupt to a sink.
+ */
+int irq_bind(pid_t owner, index_t irq, index_t i, word_t data, bool enabled)
+{
+	if (!irq_valid_access(owner, irq)) {
+		return ERR_INVALID_ACCESS;
+	}
+	if (!enabled) {
+		plic_enable(irq, false);
+		irq_table[irq] = (irq_t){.owner = owner};
+		return ERR_SUCCESS;
+	}
+	if (!ipc_signal_valid(owner, i)) {
+		return ERR_INVALID_ARGUMENT;
+	}
+	irq_table[irq] = (irq_t){.owner = owner, .bound = true, .sink = i, .data = data};
+	plic_enable(irq, true);
+	return ERR_SUCCESS;
+}
+
+/**
+ * Acknowledges a signalled interrupt.
+ */
+int irq_ack(pid_t owner, index_t irq)
+{
+	if (!irq_valid_access(owner, irq)) {
+		return ERR_INVALID_ACCESS;
+	}
+	if (!irq_table[irq].bound) {
+		return ERR_INVALID_STATE;
+	}
+	if (irq_table[irq].masked) {
+		irq_table[irq].masked = false;
+		plic_enable(irq, true);
+	}
+	return ERR_SUCCESS;
+}
+
+/**
+ * Claims and delivers pending device interrupts.
+ */
+void irq_handle(hart_t hart)
+{
+	lock_acquire(LOCK_IPC, false);
+	word_t claimed;
+	while ((claimed = plic_claim(hart)) != 0) {
+		// Mask the source until the owner acknowledges it, then let the PLIC accept it again.
+		plic_enable(claimed, false);
+		plic_complete(hart, claimed);
+		if (claimed >= ARRAY_SIZE(irq_table) || !irq_table[claimed].bound) {
+			continue;
+		}
+		irq_t *irq = &irq_table[claimed];
+		irq->masked = true;
+		if (!ipc_signal(irq->owner, irq->sink, irq->data)) {
+			// The sink was revoked or moved, leave the interrupt unbound.
+			irq->bound = false;
+		}
+	}
+	lock_release(LOCK_IPC);
+}
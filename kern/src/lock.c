@@ -1,22 +1,58 @@
+#include "lock.h"
+
 #include "preempt.h"
+#include "qlock.h"
 #include "ttas.h"
 
 #ifdef SMP
-static ttas_t ttas = {0};
+#define NUM_LOCKS 4 // One lock per capability table.
+
+#ifdef _LOCK_QUEUE
+static qlock_t locks[NUM_LOCKS];
+#define _lock_init qlock_init
+#define _lock_acquire qlock_acquire
+#define _lock_release qlock_release
+#else
+static ttas_t locks[NUM_LOCKS];
+#define _lock_init ttas_init
+#define _lock_acquire ttas_acquire
+#define _lock_release ttas_release
+#endif
 
 void lock_init(void)
 {
-	ttas_init(&ttas);
+	for (int i = 0; i < NUM_LOCKS; i++) {
+		_lock_init(&locks[i]);
+	}
 }
 
-bool lock_acquire(bool preemptable)
+bool lock_acquire(lock_set_t set, bool preemptable)
 {
-	return ttas_acquire(&ttas, preemptable);
+	if (set == LOCK_NONE) {
+		return !preemptable || !preempt();
+	}
+
+	// Acquire in increasing order to avoid deadlocks.
+	for (int i = 0; i < NUM_LOCKS; i++) {
+		if (!(set & (1 << i))) {
+			continue;
+		}
+		if (!_lock_acquire(&locks[i], preemptable)) {
+			// Preempted, release the locks taken so far.
+			lock_release(set & ((1 << i) - 1));
+			return false;
+		}
+	}
+	return true;
 }
 
-void lock_release(void)
+void lock_release(lock_set_t set)
 {
-	ttas_release(&ttas);
+	for (int i = NUM_LOCKS - 1; i >= 0; i--) {
+		if (set & (1 << i)) {
+			_lock_release(&locks[i]);
+		}
+	}
 }
 #else
 
@@ -24,12 +60,14 @@ void lock_init(void)
 {
 }
 
-bool lock_acquire(bool preemptable)
+bool lock_acquire(lock_set_t set, bool preemptable)
 {
+	(void)set;
 	return !preemptable || !preempt();
 }
 
-void lock_release(void)
+void lock_release(lock_set_t set)
 {
+	(void)set;
 }
 #endif
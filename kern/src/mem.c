@@ -1,5 +1,6 @@
 #include "mem.h"
 
+#include "ipc.h"
 #include "macro.h"
 #include "pmp.h"
 #include "preempt.h"
@@ -80,6 +81,9 @@ int mem_transfer(pid_t owner, index_t i, pid_t new_owner)
 		mem_table[i].slot = 0; // Clear the PMP slot.
 	}
 
+	// The new owner does not own the sinks using it as message buffer.
+	ipc_unbind_mem(i);
+
 	// Set the new owner.
 	mem_table[i].owner = new_owner;
 
@@ -155,6 +159,7 @@ int mem_revoke(pid_t owner, index_t i)
 		}
 		// Invalidate the child capability.
 		mem_table[j].owner = INVALID_PID;
+		ipc_unbind_mem(j);
 
 		// Reclaim the child's capability table.
 		mem_table[i].cfree += mem_table[j].cfree;
@@ -184,6 +189,7 @@ int mem_delete(pid_t owner, index_t i)
 
 	// Invalidate the capability.
 	mem_table[i].owner = INVALID_PID;
+	ipc_unbind_mem(i);
 
 	return ERR_SUCCESS;
 }
@@ -178,13 +178,24 @@ int mon_yield(pid_t owner, index_t i, proc_t **next)
 	if (UNLIKELY(!mon_valid_access(owner, i))) {
 		return ERR_INVALID_ACCESS;
 	}
-	if (UNLIKELY(!proc_acquire(mon_table[i].pid))) {
+	if (UNLIKELY(!proc_acquire_handoff(mon_table[i].pid))) {
 		return ERR_INVALID_STATE;
 	}
 	*next = proc_get(mon_table[i].pid);
 	return ERR_SUCCESS;
 }
 
+/**
+ * Checks if a register of the monitored process is live in the CPU rather than in its PCB.
+ * The system call entry does not save s0-s11, so the caller's own saved registers are only
+ * stored in its PCB when it is switched out.
+ */
+static inline bool _mon_reg_live(pid_t owner, index_t i, word_t reg)
+{
+	const word_t s0 = (offsetof(proc_t, regs.s0) - offsetof(proc_t, regs)) / sizeof(word_t);
+	return mon_table[i].pid == owner && reg >= s0;
+}
+
 /**
  * Gets a register value for the process associated with the monitor capability.
  */
@@ -199,6 +210,10 @@ int mon_reg_get(pid_t owner, index_t i, word_t reg, word_t *value)
 		return ERR_INVALID_ARGUMENT; // Invalid register index.
 	}
 
+	if (_mon_reg_live(owner, i, reg)) {
+		return ERR_INVALID_STATE;
+	}
+
 	proc_t *proc = proc_get(mon_table[i].pid);
 	word_t *reg_ptr = (word_t *)&proc->regs;
 	*value = reg_ptr[reg];
@@ -218,6 +233,10 @@ int mon_reg_set(pid_t owner, index_t i, word_t reg, word_t value)
 		return ERR_INVALID_ARGUMENT; // Invalid register index.
 	}
 
+	if (_mon_reg_live(owner, i, reg)) {
+		return ERR_INVALID_STATE;
+	}
+
 	proc_t *proc = proc_get(mon_table[i].pid);
 	word_t *reg_ptr = (word_t *)&proc->regs;
 	reg_ptr[reg] = value;
@@ -294,3 +313,16 @@ int mon_vreg_set(pid_t owner, index_t i, vreg_t reg, word_t value)
 		return ERR_INVALID_ARGUMENT;
 	}
 }
+
+/**
+ * Gets the accounting figures of the process associated with the monitor capability.
+ */
+int mon_stats(pid_t owner, index_t i, proc_stats_t *stats)
+{
+	if (UNLIKELY(!mon_valid_access(owner, i))) {
+		return ERR_INVALID_ACCESS;
+	}
+
+	*stats = proc_get(mon_table[i].pid)->acct.stats;
+	return ERR_SUCCESS;
+}
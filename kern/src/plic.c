@@ -0,0 +1,69 @@
+#include "plic.h"
+
+// External variable for the PLIC registers.
+extern volatile uint32_t __plic[];
+
+// Register offsets in words.
+#define PLIC_PRIORITY(irq) (irq)
+#define PLIC_ENABLE(ctx, irq) ((0x2000 + 0x80 * (ctx)) / 4 + (irq) / 32)
+#define PLIC_THRESHOLD(ctx) ((0x200000 + 0x1000 * (ctx)) / 4)
+#define PLIC_CLAIM(ctx) (PLIC_THRESHOLD(ctx) + 1)
+
+/**
+ * @brief Get the machine-mode context of a hart.
+ * @param hartid ID of the hardware thread.
+ * @return The PLIC context number.
+ */
+static inline word_t _plic_context(word_t hartid)
+{
+	// Each hart has a machine-mode and a supervisor-mode context.
+	return 2 * hartid;
+}
+
+/**
+ * @brief Initialize the PLIC.
+ */
+void plic_init(void)
+{
+	for (word_t irq = 1; irq < NUM_IRQ; irq++) {
+		plic_enable(irq, false);
+		__plic[PLIC_PRIORITY(irq)] = 1;
+	}
+	for (word_t hart = 0; hart < NUM_HARTS; hart++) {
+		__plic[PLIC_THRESHOLD(_plic_context(hart))] = 0;
+	}
+}
+
+/**
+ * @brief Enable or disable an interrupt source on all harts.
+ * @param irq Interrupt source number.
+ * @param enable Whether to enable the source.
+ */
+void plic_enable(word_t irq, bool enable)
+{
+	uint32_t bit = 1u << (irq % 32);
+	for (word_t hart = 0; hart < NUM_HARTS; hart++) {
+		volatile uint32_t *reg = &__plic[PLIC_ENABLE(_plic_context(hart), irq)];
+		*reg = enable ? (*reg | bit) : (*reg & ~bit);
+	}
+}
+
+/**
+ * @brief Claim a pending interrupt.
+ * @param hartid ID of the hardware thread.
+ * @return The interrupt source number, 0 if none.
+ */
+word_t plic_claim(word_t hartid)
+{
+	return __plic[PLIC_CLAIM(_plic_context(hartid))];
+}
+
+/**
+ * @brief Complete a claimed interrupt.
+ * @param hartid ID of the hardware thread.
+ * @param irq Interrupt source number.
+ */
+void plic_complete(word_t hartid, word_t irq)
+{
+	__plic[PLIC_CLAIM(_plic_context(hartid))] = irq;
+}
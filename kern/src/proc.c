@@ -1,6 +1,7 @@
 #include "proc.h"
 
 #include "csr.h"
+#include "rtc.h"
 #include "types.h"
 
 /**
@@ -8,6 +9,16 @@
  */
 static proc_t procs[MAX_PID];
 
+/**
+ * PMP image last loaded into the CSRs of each hart.
+ */
+static struct {
+	const proc_t *proc;
+	word_t gen;
+	pmp_addr_t addr[8];
+	word_t cfg;
+} pmp_loaded[_NUM_HARTS];
+
 /**
  * Retrieves the process control block (PCB) for a given process ID (PID).
  */
@@ -26,6 +37,13 @@ void proc_init(word_t init)
 		_proc(i)->regs.pc = 0;			// Set the program counter to 0 for all processes.
 		_proc(i)->pid = i;
 	}
+	// The PMP CSRs hold unknown values at boot, so force a full first load on every hart.
+	for (int hart = 0; hart < _NUM_HARTS; hart++) {
+		pmp_loaded[hart].proc = NULL;
+		pmp_loaded[hart].cfg = (word_t)-1;
+		for (int slot = 0; slot < 8; slot++)
+			pmp_loaded[hart].addr[slot] = (word_t)-1;
+	}
 	_proc(1)->state = PROC_STATE_READY; // Set the first process to the ready state.
 	_proc(1)->regs.pc = init;	    // Set the initial program counter for the first process.
 }
@@ -53,6 +71,7 @@ void proc_pmp_set(pid_t pid, pmp_slot_t slot, mem_perm_t rwx, pmp_addr_t addr)
 {
 	_proc(pid)->pmp.cfg[slot] = PMP_MODE_NAPOT | rwx; // Set PMP permissions.
 	_proc(pid)->pmp.addr[slot] = addr;		  // Set PMP address.
+	__atomic_fetch_add(&_proc(pid)->pmp.gen, 1, __ATOMIC_RELEASE);
 }
 
 /**
@@ -62,6 +81,7 @@ void proc_pmp_clear(pid_t pid, pmp_slot_t slot)
 {
 	_proc(pid)->pmp.cfg[slot] = 0;	// Clear PMP permissions.
 	_proc(pid)->pmp.addr[slot] = 0; // Clear PMP address.
+	__atomic_fetch_add(&_proc(pid)->pmp.gen, 1, __ATOMIC_RELEASE);
 }
 
 /**
@@ -81,6 +101,63 @@ void proc_pmp_get(pid_t pid, pmp_slot_t slot, mem_perm_t *rwx, pmp_addr_t *addr)
 	*addr = _proc(pid)->pmp.addr[slot];		 // Get PMP address.
 }
 
+/**
+ * Loads the PMP configuration of a process, skipping unchanged entries.
+ */
+void proc_pmp_load(const proc_t *proc)
+{
+	word_t hart = csrr_mhartid();
+	// Read the generation before the entries; a concurrent change then bumps
+	// the generation past the one recorded here and forces a reload next time.
+	word_t gen = __atomic_load_n(&proc->pmp.gen, __ATOMIC_ACQUIRE);
+	if (pmp_loaded[hart].proc == proc && pmp_loaded[hart].gen == gen)
+		return;
+
+	for (int slot = 0; slot < 8; slot++) {
+		if (pmp_loaded[hart].addr[slot] != proc->pmp.addr[slot]) {
+			pmp_loaded[hart].addr[slot] = proc->pmp.addr[slot];
+			csrw_pmpaddr(slot, proc->pmp.addr[slot]);
+		}
+	}
+
+	word_t cfg;
+	__builtin_memcpy(&cfg, proc->pmp.cfg, sizeof(cfg));
+	if (pmp_loaded[hart].cfg != cfg) {
+		pmp_loaded[hart].cfg = cfg;
+		csrw_pmpcfg0(cfg);
+	}
+
+	pmp_loaded[hart].proc = proc;
+	pmp_loaded[hart].gen = gen;
+}
+
+/**
+ * Starts accounting a dispatch of a process.
+ */
+void proc_account_start(proc_t *proc, bool donated)
+{
+	proc->acct.start = rtc_get_time();
+	proc->acct.donated = donated;
+	proc->acct.stats.switches++;
+}
+
+/**
+ * Adds the time since the process was dispatched to its figures.
+ * The process is still acquired, so no other hart updates them.
+ */
+void proc_account_stop(proc_t *proc)
+{
+	uint64_t runtime = rtc_get_time() - proc->acct.start;
+	proc->acct.stats.runtime += runtime;
+	if (proc->acct.donated) {
+		proc->acct.stats.donated += runtime;
+	}
+	// An interrupt cause has the most significant bit set.
+	if ((long)csrr_mcause() < 0) {
+		proc->acct.stats.preemptions++;
+	}
+}
+
 /**
  * Sets a register value for a process.
  */
@@ -99,16 +176,38 @@ word_t proc_get_register(pid_t pid, word_t regid)
 	return reg[regid]; // Get the register value.
 }
 
+/**
+ * Atomically changes the state of a process from expected to desired.
+ * The state is shared with other harts, which may acquire or release the process concurrently.
+ */
+static inline bool _proc_cas_state(pid_t pid, word_t expected, word_t desired)
+{
+	return __atomic_compare_exchange_n(&_proc(pid)->state, &expected, desired, false, __ATOMIC_ACQ_REL,
+					   __ATOMIC_RELAXED);
+}
+
 /**
  * Acquires a process by its PID.
  */
 bool proc_acquire(pid_t pid)
 {
-	proc_state_t state = _proc(pid)->state;
-	if (state != PROC_STATE_READY) {
+	// Mark the process as acquired if it is ready.
+	return _proc_cas_state(pid, PROC_STATE_READY, PROC_STATE_ACQUIRED);
+}
+
+/**
+ * Acquires a process by its PID to switch to it, unless it has a deferred system call.
+ */
+bool proc_acquire_handoff(pid_t pid)
+{
+	if (!proc_acquire(pid)) {
+		return false;
+	}
+	// The scheduler finishes the call before the process may run.
+	if (_proc(pid)->cont) {
+		proc_release(pid);
 		return false;
 	}
-	_proc(pid)->state = PROC_STATE_ACQUIRED; // Mark the process as acquired.
 	return true;
 }
 
@@ -117,8 +216,11 @@ bool proc_acquire(pid_t pid)
  */
 void proc_suspend(pid_t pid)
 {
-	_proc(pid)->state &= PROC_STATE_ACQUIRED;  // Remove all other states but acquired.
-	_proc(pid)->state |= PROC_STATE_SUSPENDED; // Mark the process as suspended.
+	word_t state = __atomic_load_n(&_proc(pid)->state, __ATOMIC_RELAXED);
+	// Remove all other states but acquired, then mark the process as suspended.
+	while (!_proc_cas_state(pid, state, (state & PROC_STATE_ACQUIRED) | PROC_STATE_SUSPENDED)) {
+		state = __atomic_load_n(&_proc(pid)->state, __ATOMIC_RELAXED);
+	}
 }
 
 /**
@@ -126,7 +228,7 @@ void proc_suspend(pid_t pid)
  */
 void proc_resume(pid_t pid)
 {
-	_proc(pid)->state &= ~PROC_STATE_SUSPENDED; // Remove the suspended state.
+	__atomic_fetch_and(&_proc(pid)->state, ~PROC_STATE_SUSPENDED, __ATOMIC_RELEASE); // Remove the suspended state.
 }
 
 /**
@@ -137,12 +239,33 @@ bool proc_ipc_acquire(pid_t pid, index_t i)
 {
 	word_t expected = PROC_STATE_BLOCKED | i << 4;
 	word_t desired = PROC_STATE_ACQUIRED;
+	// Fails if the process is not in the expected state.
+	return _proc_cas_state(pid, expected, desired);
+}
 
-	if (_proc(pid)->state != expected) {
-		return false; // Process is not in the expected state, cannot acquire.
-	}
-	_proc(pid)->state = desired; // Mark the process as acquired.
-	return true;
+/**
+ * Checks if a process is blocked waiting on an IPC capability.
+ * The process may still be switching out or be suspended.
+ */
+bool proc_ipc_blocked_on(pid_t pid, index_t i)
+{
+	word_t state = __atomic_load_n(&_proc(pid)->state, __ATOMIC_RELAXED);
+	state &= ~(word_t)(PROC_STATE_ACQUIRED | PROC_STATE_SUSPENDED);
+	return state == (PROC_STATE_BLOCKED | (word_t)i << 4);
+}
+
+/**
+ * Cancels the IPC wait of a blocked process, acquiring it.
+ * Stores the index of the IPC capability it waited on in i.
+ * Fails if the process is not blocked, is switching out or is suspended.
+ */
+bool proc_ipc_cancel(pid_t pid, index_t *i)
+{
+	word_t state = __atomic_load_n(&_proc(pid)->state, __ATOMIC_RELAXED);
+	if ((state & (PROC_STATE_BLOCKED | PROC_STATE_ACQUIRED | PROC_STATE_SUSPENDED)) != PROC_STATE_BLOCKED)
+		return false;
+	*i = state >> 4;
+	return _proc_cas_state(pid, state, PROC_STATE_ACQUIRED);
 }
 
 /**
@@ -153,11 +276,8 @@ bool proc_ipc_block(pid_t pid, index_t i)
 {
 	word_t expected = PROC_STATE_ACQUIRED;
 	word_t desired = PROC_STATE_BLOCKED | PROC_STATE_ACQUIRED | i << 4;
-	if (_proc(pid)->state != expected) {
-		return false; // Process is not in the expected state, cannot block.
-	}
-	_proc(pid)->state = desired; // Mark the process as blocked.
-	return true;
+	// Fails if the process is not in the expected state.
+	return _proc_cas_state(pid, expected, desired);
 }
 
 /**
@@ -165,5 +285,5 @@ bool proc_ipc_block(pid_t pid, index_t i)
  */
 void proc_release(pid_t pid)
 {
-	_proc(pid)->state &= ~PROC_STATE_ACQUIRED; // Mark the process as ready.
+	__atomic_fetch_and(&_proc(pid)->state, ~PROC_STATE_ACQUIRED, __ATOMIC_RELEASE); // Mark the process as ready.
 }
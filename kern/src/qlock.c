@@ -0,0 +1,73 @@
+#include "qlock.h"
+
+#include "csr.h"
+#include "preempt.h"
+
+// Wait states of a hart.
+#define QLOCK_IDLE 0	// Not waiting for the lock.
+#define QLOCK_WAITING 1 // Waiting for the lock.
+#define QLOCK_GRANTED 2 // The lock was handed over by the previous holder.
+
+void qlock_init(qlock_t *qlock)
+{
+	qlock->held = 0;
+	for (int i = 0; i < _NUM_HARTS; i++) {
+		qlock->wait[i] = QLOCK_IDLE;
+	}
+}
+
+bool qlock_acquire(qlock_t *qlock, bool preemptable)
+{
+	word_t hart = csrr_mhartid();
+	word_t expected;
+
+	// Announce that we are waiting, so the holder can hand the lock to us.
+	__atomic_store_n(&qlock->wait[hart], QLOCK_WAITING, __ATOMIC_SEQ_CST);
+	while (1) {
+		// The previous holder handed the lock to us.
+		if (__atomic_load_n(&qlock->wait[hart], __ATOMIC_ACQUIRE) == QLOCK_GRANTED) {
+			break;
+		}
+
+		// The lock was released with no hart waiting.
+		expected = 0;
+		if (!__atomic_load_n(&qlock->held, __ATOMIC_RELAXED)
+		    && __atomic_compare_exchange_n(&qlock->held, &expected, 1, false, __ATOMIC_ACQUIRE,
+						   __ATOMIC_RELAXED)) {
+			break;
+		}
+
+		if (preemptable && preempt()) {
+			// Withdraw, unless the lock was handed to us in the meantime.
+			expected = QLOCK_WAITING;
+			if (__atomic_compare_exchange_n(&qlock->wait[hart], &expected, QLOCK_IDLE, false,
+							__ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+				return false;
+			}
+			// We got the lock, pass it on.
+			__atomic_store_n(&qlock->wait[hart], QLOCK_IDLE, __ATOMIC_RELAXED);
+			qlock_release(qlock);
+			return false;
+		}
+	}
+	__atomic_store_n(&qlock->wait[hart], QLOCK_IDLE, __ATOMIC_RELAXED);
+	return true;
+}
+
+void qlock_release(qlock_t *qlock)
+{
+	word_t hart = csrr_mhartid();
+
+	// Hand the lock to the next waiting hart in round-robin order.
+	for (word_t i = 1; i < _NUM_HARTS; i++) {
+		word_t next = (hart + i) % _NUM_HARTS;
+		word_t expected = QLOCK_WAITING;
+		if (__atomic_compare_exchange_n(&qlock->wait[next], &expected, QLOCK_GRANTED, false, __ATOMIC_RELEASE,
+						__ATOMIC_RELAXED)) {
+			return;
+		}
+	}
+
+	// No hart is waiting, free the lock.
+	__atomic_store_n(&qlock->held, 0, __ATOMIC_RELEASE);
+}
@@ -1,8 +1,14 @@
 #include "sched.h"
 
 #include "csr.h"
-#include "lock.h"
+#include "current.h"
+#include "ipc.h"
+#include "ipi.h"
+#include "irq.h"
+#include "preempt.h"
 #include "rtc.h"
+#include "syscall.h"
+#include "ttas.h"
 
 extern void temporal_fence(void);
 
@@ -12,40 +18,208 @@ typedef struct frame {
 	uint16_t length; // Length of the slot in time units
 } frame_t;
 
-// Scheduling table: for each hart (hardware thread), an array of frames
-frame_t schedule[_NUM_HARTS][MAX_TIME_SLOT];
+// Scheduling tables: for each hart (hardware thread) and schedule mode, an array of frames
+frame_t schedule[_NUM_HARTS][NUM_SCHED_MODES][MAX_TIME_SLOT];
 
-// Current slot index for each hart
-uint64_t curr[_NUM_HARTS];
+// Current slot of each hart, as an offset in its current major frame
+time_slot_t curr[_NUM_HARTS];
+
+// Time at which the current major frame of each hart began, kept with curr so slots never need a division
+static uint64_t period_start[_NUM_HARTS];
+
+// Slot layout for each hart and mode: offset in ticks of each slot from the start of the major frame,
+// entry MAX_TIME_SLOT is the length of the major frame
+static uint64_t slot_begin[_NUM_HARTS][NUM_SCHED_MODES][MAX_TIME_SLOT + 1];
+
+// Requested slot lengths in ticks, applied to the layout at the start of a major frame in the mode
+static uint32_t slot_ticks[_NUM_HARTS][NUM_SCHED_MODES][MAX_TIME_SLOT];
+static bool slot_ticks_changed[_NUM_HARTS][NUM_SCHED_MODES];
+
+// Active schedule mode of each hart, and the mode it switches to at the next major frame
+static sched_mode_t mode[_NUM_HARTS];
+static sched_mode_t next_mode[_NUM_HARTS];
+
+// Occupancy bitmap for each hart and mode: bit i is set if slot i starts a frame with a valid PID
+#define OCCUPANCY_WORDS ((MAX_TIME_SLOT + 63) / 64)
+static uint64_t occupied[_NUM_HARTS][NUM_SCHED_MODES][OCCUPANCY_WORDS];
+
+// Structure representing a slack recipient, gets idle time of frames in [begin, end)
+typedef struct slack {
+	pid_t pid;	   // Process ID of the recipient, INVALID_PID if none
+	sched_mode_t mode; // Schedule mode of the donated slots
+	time_slot_t begin; // Start of the donated slots
+	time_slot_t end;   // End of the donated slots
+} slack_t;
+
+// Slack recipient for each hart
+static slack_t slack[_NUM_HARTS];
+
+#ifdef SMP
+// Per-hart locks for the schedules, curr, modes, occupancy bitmaps and slack recipient of each hart
+static ttas_t sched_locks[_NUM_HARTS];
+#endif
+
+/**
+ * Locks the scheduling state of a hart.
+ */
+static inline void _sched_lock(hart_t hart)
+{
+#ifdef SMP
+	ttas_acquire(&sched_locks[hart], false);
+#else
+	(void)hart;
+#endif
+}
+
+/**
+ * Unlocks the scheduling state of a hart, publishing updates to other harts.
+ */
+static inline void _sched_unlock(hart_t hart)
+{
+#ifdef SMP
+	ttas_release(&sched_locks[hart]);
+#else
+	(void)hart;
+#endif
+}
+
+/**
+ * Returns the time at which a slot of the current major frame of a hart begins.
+ * Offset MAX_TIME_SLOT is the end of the major frame.
+ */
+static inline uint64_t _slot_time(hart_t hart, uint64_t offset)
+{
+	return period_start[hart] + slot_begin[hart][mode[hart]][offset];
+}
+
+/**
+ * Recomputes the slot layout of a mode from the requested slot lengths.
+ */
+static void _slot_layout(hart_t hart, sched_mode_t m)
+{
+	uint64_t begin = 0;
+	for (uint64_t i = 0; i < MAX_TIME_SLOT; i++) {
+		slot_begin[hart][m][i] = begin;
+		begin += slot_ticks[hart][m][i];
+	}
+	slot_begin[hart][m][MAX_TIME_SLOT] = begin;
+	slot_ticks_changed[hart][m] = false;
+}
+
+/**
+ * Starts the next major frame of a hart.
+ * Requested mode switches and slot lengths take effect here, so a major frame never mixes two layouts.
+ */
+static void _next_period(hart_t hart)
+{
+	period_start[hart] += slot_begin[hart][mode[hart]][MAX_TIME_SLOT];
+	mode[hart] = next_mode[hart];
+	if (slot_ticks_changed[hart][mode[hart]]) {
+		_slot_layout(hart, mode[hart]);
+	}
+}
+
+/**
+ * Marks the frame starting at slot as occupied if pid is valid, otherwise as free.
+ */
+static inline void _occupancy_set(hart_t hart, sched_mode_t m, uint64_t slot, pid_t pid)
+{
+	uint64_t bit = 1ull << (slot % 64);
+	if (pid != INVALID_PID)
+		occupied[hart][m][slot / 64] |= bit;
+	else
+		occupied[hart][m][slot / 64] &= ~bit;
+}
+
+/**
+ * Marks all slots in [begin, end) as free.
+ */
+static void _occupancy_clear(hart_t hart, sched_mode_t m, uint64_t begin, uint64_t end)
+{
+	for (uint64_t i = begin; i < end; i = (i | 63) + 1) {
+		uint64_t mask = ~0ull << (i % 64);
+		// Keep the bits at and after end if end lies in this word
+		if (end - (i & ~63ull) < 64)
+			mask &= ~(~0ull << (end % 64));
+		occupied[hart][m][i / 64] &= ~mask;
+	}
+}
 
 /**
- * Returns the current global scheduling slot based on the RTC.
+ * Returns the distance from offset to the next occupied frame,
+ * or to the end of the major frame if no occupied frame follows.
  */
-uint64_t sched_rtc_slot()
+static uint64_t _next_occupied(hart_t hart, sched_mode_t m, uint64_t offset)
 {
-	return (rtc_get_time() / TIME_SLOT_TICKS);
+	for (uint64_t i = offset + 1; i < MAX_TIME_SLOT; i = (i | 63) + 1) {
+		uint64_t bits = occupied[hart][m][i / 64] >> (i % 64);
+		if (bits)
+			return i + __builtin_ctzll(bits) - offset;
+	}
+	return MAX_TIME_SLOT - offset;
 }
 
 /**
- * Converts a slot index to an absolute time value.
+ * Returns the current frame of a hart in its active schedule.
  */
-uint64_t slot2time(uint64_t slot)
+static inline frame_t _frame(hart_t hart)
 {
-	return (slot * TIME_SLOT_TICKS);
+	return schedule[hart][mode[hart]][curr[hart]];
+}
+
+/**
+ * Returns the slot offset where the current frame of a hart ends, at most MAX_TIME_SLOT.
+ * Unoccupied frames extend to the next occupied frame.
+ */
+static uint64_t _frame_end(hart_t hart)
+{
+	frame_t frame = _frame(hart);
+	if (frame.pid == INVALID_PID)
+		return curr[hart] + _next_occupied(hart, mode[hart], curr[hart]);
+	return curr[hart] + frame.length;
+}
+
+/**
+ * Makes a remote hart re-read its schedule by interrupting it.
+ */
+static void _sched_kick(hart_t hart)
+{
+#ifdef SMP
+	if (hart != csrr_mhartid())
+		ipi_send(hart);
+#else
+	(void)hart;
+#endif
 }
 
 /**
  * Initializes the scheduler:
- * - Sets up the initial schedule for each hart.
- * - Assigns the first slot to PID 1 on hart 0, INVALID_PID elsewhere.
+ * - Sets up the initial schedule for each hart and mode, all harts start in mode 0.
+ * - Assigns the first slot to PID 1 on hart 0 in mode 0, INVALID_PID elsewhere.
+ * - Gives every slot a length of TIME_SLOT_TICKS.
  * - Resets the current slot and RTC.
  */
 void sched_init(void)
 {
 	for (int hart = 0; hart < _NUM_HARTS; hart++) {
-		schedule[hart][0].pid = (hart == 0) ? 1 : INVALID_PID;
-		schedule[hart][0].length = MAX_TIME_SLOT;
+		for (sched_mode_t m = 0; m < NUM_SCHED_MODES; m++) {
+			schedule[hart][m][0].pid = (hart == 0 && m == 0) ? 1 : INVALID_PID;
+			schedule[hart][m][0].length = MAX_TIME_SLOT;
+			_occupancy_clear(hart, m, 0, MAX_TIME_SLOT);
+			_occupancy_set(hart, m, 0, schedule[hart][m][0].pid);
+			for (uint64_t i = 0; i < MAX_TIME_SLOT; i++) {
+				slot_ticks[hart][m][i] = TIME_SLOT_TICKS;
+			}
+			_slot_layout(hart, m);
+		}
 		curr[hart] = 0;
+		period_start[hart] = 0;
+		mode[hart] = 0;
+		next_mode[hart] = 0;
+		slack[hart].pid = INVALID_PID;
+#ifdef SMP
+		ttas_init(&sched_locks[hart]);
+#endif
 	}
 	rtc_set_time(0);
 }
@@ -54,16 +228,22 @@ void sched_init(void)
  * Reclaims a range of scheduling slots [begin, end) for a specific process.
  * If the current slot is within this range, updates curr to begin.
  */
-void sched_reclaim(hart_t hart, pid_t pid, time_slot_t begin, time_slot_t end)
+void sched_reclaim(hart_t hart, sched_mode_t m, pid_t pid, time_slot_t begin, time_slot_t end)
 {
-	schedule[hart][begin].pid = pid;
-	schedule[hart][begin].length = end - begin;
+	_sched_lock(hart);
+	schedule[hart][m][begin].pid = pid;
+	schedule[hart][m][begin].length = end - begin;
+
+	// The merged frames no longer start inside the range
+	_occupancy_clear(hart, m, begin, end);
+	_occupancy_set(hart, m, begin, pid);
 
 	// If the current slot is within the reclaimed range, update it to begin
-	uint64_t curr_local = curr[hart] % MAX_TIME_SLOT;
-	if (begin <= curr_local && curr_local < end) {
-		curr[hart] += begin - curr_local;
+	if (m == mode[hart] && begin <= curr[hart] && curr[hart] < end) {
+		curr[hart] = begin;
 	}
+	_sched_kick(hart);
+	_sched_unlock(hart);
 }
 
 /**
@@ -72,74 +252,214 @@ void sched_reclaim(hart_t hart, pid_t pid, time_slot_t begin, time_slot_t end)
  * - [middle, end): new PID
  * If middle == begin, just sets the PID for the slot.
  */
-void sched_split(hart_t hart, pid_t pid, time_slot_t begin, time_slot_t middle, time_slot_t end)
+void sched_split(hart_t hart, sched_mode_t m, pid_t pid, time_slot_t begin, time_slot_t middle, time_slot_t end)
 {
-	schedule[hart][begin].length = middle - begin;
-	schedule[hart][middle].pid = pid;
-	schedule[hart][middle].length = end - middle;
+	_sched_lock(hart);
+	schedule[hart][m][begin].length = middle - begin;
+	schedule[hart][m][middle].pid = pid;
+	schedule[hart][m][middle].length = end - middle;
+	_occupancy_set(hart, m, middle, pid);
 
-	uint64_t curr_local = curr[hart] % MAX_TIME_SLOT;
-	if (curr_local == begin) {
+	if (m == mode[hart] && curr[hart] == begin) {
 		// If currently at 'begin', possibly advance to 'middle'
-		middle = curr[hart] + middle - begin;
-		if (middle < sched_rtc_slot()) {
+		if (_slot_time(hart, middle) <= rtc_get_time()) {
 			curr[hart] = middle;
 		}
 	}
+	_sched_kick(hart);
+	_sched_unlock(hart);
 }
 
 /**
  * Sets the PID for a specific slot on a hart.
  * Used when enabling/disabling tsl capabilities.
  */
-void sched_set_pid(hart_t hart, pid_t pid, time_slot_t begin)
+void sched_set_pid(hart_t hart, sched_mode_t m, pid_t pid, time_slot_t begin)
+{
+	_sched_lock(hart);
+	schedule[hart][m][begin].pid = pid;
+	_occupancy_set(hart, m, begin, pid);
+	_sched_kick(hart);
+	_sched_unlock(hart);
+}
+
+/**
+ * Sets the slack recipient of a hart.
+ */
+void sched_set_slack(hart_t hart, sched_mode_t m, pid_t pid, time_slot_t begin, time_slot_t end)
+{
+	_sched_lock(hart);
+	slack[hart] = (slack_t){.pid = pid, .mode = m, .begin = begin, .end = end};
+	_sched_unlock(hart);
+}
+
+/**
+ * Requests a hart to switch schedule mode at its next major frame.
+ */
+void sched_set_mode(hart_t hart, sched_mode_t m)
+{
+	_sched_lock(hart);
+	next_mode[hart] = m;
+	_sched_unlock(hart);
+}
+
+/**
+ * Sets the length of a slot of a mode, effective at the next major frame in the mode.
+ */
+void sched_set_ticks(hart_t hart, sched_mode_t m, time_slot_t slot, uint32_t ticks)
+{
+	_sched_lock(hart);
+	slot_ticks[hart][m][slot] = ticks;
+	slot_ticks_changed[hart][m] = true;
+	_sched_unlock(hart);
+}
+
+/**
+ * Gets the active schedule mode of a hart.
+ */
+sched_mode_t sched_get_mode(hart_t hart)
+{
+	return mode[hart];
+}
+
+/**
+ * Gets the slack recipient of a hart.
+ */
+pid_t sched_get_slack(hart_t hart)
+{
+	return slack[hart].pid;
+}
+
+/**
+ * Makes remote harts whose current frame belongs to a process reschedule,
+ * so a process readied by another hart runs without waiting for the frame end.
+ */
+void sched_wake(pid_t pid)
+{
+	// A slack recipient waking the owner of this hart's frame gives the frame back.
+	hart_t self = csrr_mhartid();
+	if (_frame(self).pid == pid && current != NULL && current->pid != pid)
+		ipi_send(self);
+#ifdef SMP
+	for (hart_t hart = 0; hart < NUM_HARTS; hart++) {
+		// Unlocked read, a stale frame only delays the wakeup to the frame end or sends a spurious interrupt.
+		if (_frame(hart).pid == pid)
+			_sched_kick(hart);
+	}
+#else
+	(void)pid;
+#endif
+}
+
+/**
+ * Tries to acquire a process and gives it time until timeout.
+ */
+static proc_t *_sched_acquire(pid_t pid, uint64_t now, uint64_t timeout)
+{
+	if (pid == INVALID_PID) {
+		return NULL; // No process scheduled for this slot
+	}
+
+	proc_t *proc = proc_get(pid);
+	if (proc->timeout > now) {
+		return NULL; // Process is sleeping or waiting
+	}
+
+	// Try to acquire the process, its state is updated atomically
+	if (!proc_acquire(pid)) {
+		// A process blocked on IPC past its deadline resumes with a timeout
+		if (!ipc_cancel(pid)) {
+			return NULL;
+		}
+		proc->regs.a0 = ERR_TIMEOUT;
+	}
+	proc->timeout = timeout;
+	return proc;
+}
+
+/**
+ * Returns the time a process that is sleeping or waiting with a deadline becomes runnable,
+ * or UINT64_MAX if it has no pending wakeup after now.
+ */
+static uint64_t _sched_wakeup(pid_t pid, uint64_t now)
 {
-	schedule[hart][begin].pid = pid;
+	if (pid == INVALID_PID) {
+		return UINT64_MAX;
+	}
+	uint64_t timeout = proc_get(pid)->timeout;
+	return timeout > now ? timeout : UINT64_MAX;
 }
 
 /**
  * Retrieves the next process to run for a given hart.
  * Advances the current slot if needed, checks for valid and ready processes.
- * Sets the timeout for the next scheduling event.
+ * Sets the timeout for the next scheduling event, skipping unoccupied frames.
+ * If the frame's process cannot run, the hart's slack recipient may use the frame.
+ * If neither can run, the timer is set to when one of them wakes, if that is before the frame ends.
  */
 static proc_t *sched_next(hart_t hart, uint64_t *timeout)
 {
 	bool swapped = false;
 
-	// Lock because other processes may be accessing the schedule
-	lock_acquire(false);
-	uint64_t rtc_slot = sched_rtc_slot();
-	uint64_t offset = curr[hart] % MAX_TIME_SLOT;
-	// Advance curr if the current slot has expired
-	if (curr[hart] + schedule[hart][offset].length <= rtc_slot) {
-		curr[hart] += schedule[hart][offset].length;
+	// Lock because other harts may be updating this hart's schedule
+	_sched_lock(hart);
+	uint64_t time = rtc_get_time();
+	// Advance curr past all expired frames, frames never cross a major frame
+	uint64_t end = _frame_end(hart);
+	while (_slot_time(hart, end) <= time) {
+		if (end == MAX_TIME_SLOT) {
+			_next_period(hart);
+			end = 0;
+		}
+		curr[hart] = end;
+		end = _frame_end(hart);
 		swapped = true;
 	}
-	frame_t slot = schedule[hart][curr[hart] % MAX_TIME_SLOT];
-	*timeout = slot2time(curr[hart] + slot.length);
-	lock_release();
+	frame_t slot = _frame(hart);
+	*timeout = _slot_time(hart, end);
+
+	// Slack is only donated within the slots of the recipient's capability
+	slack_t sl = slack[hart];
+	bool use_slack = sl.pid != INVALID_PID && sl.mode == mode[hart] && _slot_time(hart, sl.begin) <= time
+			 && time < _slot_time(hart, sl.end);
+	if (use_slack && sl.end < end) {
+		*timeout = _slot_time(hart, sl.end);
+	}
+
+	// Set the timer for the next scheduling event
+	rtc_set_timeout(hart, *timeout);
+	_sched_unlock(hart);
 	// Release lock because we do not want to block when executing temporal fence.
 
 	if (swapped) {
 		temporal_fence(); // Insert a temporal fence if we swapped slots
 	}
 
-	if (slot.pid == INVALID_PID) {
-		return NULL; // No process scheduled for this slot
+	// Try the process owning the frame, then the slack recipient.
+	uint64_t now = rtc_get_time();
+	proc_t *proc = _sched_acquire(slot.pid, now, *timeout);
+	if (proc == NULL && use_slack) {
+		proc = _sched_acquire(sl.pid, now, *timeout);
+		// The recipient only runs until the frame's process wakes.
+		uint64_t wakeup = _sched_wakeup(slot.pid, now);
+		if (proc != NULL && wakeup < *timeout) {
+			*timeout = wakeup;
+			proc->timeout = wakeup;
+			rtc_set_timeout(hart, wakeup);
+		}
 	}
 
-	// We now have a process we may schedule.
-	proc_t *proc = proc_get(slot.pid);
-	if (proc->timeout > slot2time(rtc_slot)) {
-		return NULL; // Process is sleeping or waiting
+	if (proc == NULL) {
+		// Wake up when a sleeping process of this frame may run, not only at the frame end.
+		uint64_t wakeup = _sched_wakeup(slot.pid, now);
+		if (use_slack && _sched_wakeup(sl.pid, now) < wakeup) {
+			wakeup = _sched_wakeup(sl.pid, now);
+		}
+		if (wakeup < *timeout) {
+			rtc_set_timeout(hart, wakeup);
+		}
 	}
-
-	// Try to acquire the process
-	lock_acquire(false);
-	bool proc_acquired = proc_acquire(slot.pid);
-	proc->timeout = *timeout;
-	lock_release();
-	return proc_acquired ? proc : NULL;
+	return proc;
 }
 
 /**
@@ -152,15 +472,31 @@ proc_t *sched(void)
 	uint64_t timeout;
 
 	while (1) {
+		// Acknowledge wakeups, the schedule is read after this
+		ipi_clear(hart);
+		// Deliver device interrupts, their receivers may run next
+		if (csrr_mip() & MIP_MEIP) {
+			irq_handle(hart);
+		}
 		proc_t *next = sched_next(hart, &timeout);
-		rtc_set_timeout(hart, timeout);
+
+		// Finish a deferred system call before the process runs
+		if (next != NULL && next->cont && !syscall_resume(next)) {
+			proc_release(next->pid);
+			continue;
+		}
 
 		if (next != NULL) {
 			return next; // Return the next ready process
 		}
 
-		// Wait for interrupt if no process is ready
-		while (!(csrr_mip() & 128)) {
+		// Spend idle time on deferred system calls, then check the schedule again
+		if (syscall_resume_deferred()) {
+			continue;
+		}
+
+		// Wait for the timer, a wakeup or a device if no process is ready
+		while (!preempt()) {
 			__asm__ volatile("wfi");
 		}
 	}
@@ -4,6 +4,7 @@
 #include "current.h"
 #include "exception.h"
 #include "ipc.h"
+#include "irq.h"
 #include "lock.h"
 #include "macro.h"
 #include "mem.h"
@@ -11,6 +12,7 @@
 #include "preempt.h"
 #include "proc.h"
 #include "rtc.h"
+#include "sched.h"
 #include "tsl.h"
 #include "ttas.h"
 
@@ -595,7 +597,7 @@ static proc_t *syscall_ipc_send(pid_t pid, word_t args[8])
 static proc_t *syscall_ipc_recv(pid_t pid, word_t args[8])
 {
 	proc_t *next = current;
-	args[0] = ipc_recv(pid, args[1], &next, args[2]);
+	args[0] = ipc_recv(pid, args[1], &next, args[2], args[3]);
 	return next;
 }
 
@@ -606,7 +608,7 @@ static proc_t *syscall_ipc_call(pid_t pid, word_t args[8])
 {
 	proc_t *next = current;
 	word_t data[2] = {args[2], args[3]};
-	args[0] = ipc_call(pid, args[1], data, args[4], args[5], &next);
+	args[0] = ipc_call(pid, args[1], data, args[4], args[5], &next, args[6]);
 	return next;
 }
 
@@ -628,7 +630,7 @@ static proc_t *syscall_ipc_replyrecv(pid_t pid, word_t args[8])
 {
 	proc_t *next = current;
 	word_t data[2] = {args[2], args[3]};
-	args[0] = ipc_replyrecv(pid, args[1], data, args[4], args[5], &next, args[6]);
+	args[0] = ipc_replyrecv(pid, args[1], data, args[4], args[5], &next, args[6], args[7]);
 	return next;
 }
 
@@ -654,72 +656,427 @@ static proc_t *syscall_ipc_arecv(pid_t pid, word_t args[8])
 	return next;
 }
 
+/**
+ * Bind or unbind a memory capability as the message buffer of an IPC sink.
+ */
+static proc_t *syscall_ipc_bind(pid_t pid, word_t args[8])
+{
+	args[0] = ipc_bind(pid, args[1], args[2], args[3]);
+	return current;
+}
+
+/**
+ * Wait to receive an IPC message on any sink in a set.
+ */
+static proc_t *syscall_ipc_recv_set(pid_t pid, word_t args[8])
+{
+	proc_t *next = current;
+	args[0] = ipc_recv_set(pid, args[1], args[2], &next, args[3], args[4]);
+	return next;
+}
+
+/**
+ * Donate the idle time of a time slice capability to the current process.
+ */
+static proc_t *syscall_tsl_slack(pid_t pid, word_t args[8])
+{
+	args[0] = tsl_slack(pid, args[1], args[2] ? pid : INVALID_PID);
+	return current;
+}
+
+/**
+ * Donate the idle time of a time slice capability to the process being monitored by the specified monitor capability.
+ */
+static proc_t *syscall_mon_tsl_slack(pid_t pid, word_t args[8])
+{
+	pid_t target = mon_get_pid(pid, args[1]);
+	args[0] = ERR_INVALID_ACCESS;
+	if (target != INVALID_PID) {
+		args[0] = tsl_slack(pid, args[2], args[3] ? target : INVALID_PID);
+	}
+	return current;
+}
+
+/**
+ * Bind or unbind an interrupt capability to an asynchronous or notification sink.
+ */
+static proc_t *syscall_irq_bind(pid_t pid, word_t args[8])
+{
+	args[0] = irq_bind(pid, args[1], args[2], args[3], args[4]);
+	return current;
+}
+
+/**
+ * Acknowledge a signalled interrupt, unmasking it.
+ */
+static proc_t *syscall_irq_ack(pid_t pid, word_t args[8])
+{
+	args[0] = irq_ack(pid, args[1]);
+	return current;
+}
+
+/**
+ * Grant an interrupt capability to the process being monitored by the specified monitor capability.
+ */
+static proc_t *syscall_mon_irq_grant(pid_t pid, word_t args[8])
+{
+	pid_t target = mon_get_pid(pid, args[1]);
+	args[0] = ERR_INVALID_ACCESS;
+	if (target != INVALID_PID) {
+		args[0] = irq_transfer(pid, args[2], target);
+	}
+	return current;
+}
+
+/**
+ * Switch the hart of a time slice capability to its schedule mode at the next major frame.
+ */
+static proc_t *syscall_tsl_mode(pid_t pid, word_t args[8])
+{
+	args[0] = tsl_mode(pid, args[1]);
+	return current;
+}
+
+/**
+ * Set the length in ticks of a slot in the schedule mode of a time slice capability.
+ */
+static proc_t *syscall_tsl_ticks(pid_t pid, word_t args[8])
+{
+	if (args[2] >= MAX_TIME_SLOT || args[3] > UINT32_MAX) {
+		args[0] = ERR_INVALID_ARGUMENT;
+		return current;
+	}
+	args[0] = tsl_ticks(pid, args[1], args[2], args[3]);
+	return current;
+}
+
+/**
+ * Get the accounting figures of the process being monitored by the specified monitor capability.
+ */
+static proc_t *syscall_mon_stats(pid_t pid, word_t args[8])
+{
+	args[0] = mon_stats(pid, args[1], (proc_stats_t *)&args[1]);
+	return current;
+}
+
 /**
  * Handler type for system calls.
  */
 typedef proc_t *(*handler_t)(pid_t pid, word_t args[8]);
 
 /**
- * Handlers for individual system calls.
- */
-handler_t handlers[] = {
-	syscall_pid_get,
-	syscall_vreg_get,
-	syscall_vreg_set,
-	syscall_sync,
-	syscall_sleep_until,
-	syscall_mem_introspect,
-	syscall_tsl_introspect,
-	syscall_mon_introspect,
-	syscall_ipc_introspect,
-	syscall_mem_derive,
-	syscall_tsl_derive,
-	syscall_mon_derive,
-	syscall_ipc_derive,
-	syscall_mem_revoke,
-	syscall_tsl_revoke,
-	syscall_mon_revoke,
-	syscall_ipc_revoke,
-	syscall_mem_delete,
-	syscall_tsl_delete,
-	syscall_mon_delete,
-	syscall_ipc_delete,
-	syscall_mem_pmp_get,
-	syscall_mem_pmp_set,
-	syscall_mem_pmp_clear,
-	syscall_tsl_set,
-	syscall_mon_suspend,
-	syscall_mon_resume,
-	syscall_mon_yield,
-	syscall_mon_reg_get,
-	syscall_mon_reg_set,
-	syscall_mon_vreg_get,
-	syscall_mon_vreg_set,
-	syscall_mon_mem_introspect,
-	syscall_mon_tsl_introspect,
-	syscall_mon_mon_introspect,
-	syscall_mon_ipc_introspect,
-	syscall_mon_mem_grant,
-	syscall_mon_tsl_grant,
-	syscall_mon_mon_grant,
-	syscall_mon_ipc_grant,
-	syscall_mon_mem_derive,
-	syscall_mon_tsl_derive,
-	syscall_mon_mon_derive,
-	syscall_mon_ipc_derive,
-	syscall_mon_mem_pmp_get,
-	syscall_mon_mem_pmp_set,
-	syscall_mon_mem_pmp_clear,
-	syscall_mon_tsl_set,
-	syscall_ipc_send,
-	syscall_ipc_recv,
-	syscall_ipc_call,
-	syscall_ipc_reply,
-	syscall_ipc_replyrecv,
-	syscall_ipc_asend,
-	syscall_ipc_arecv,
+ * The syscall also needs the lock of the capability type in args[4].
+ */
+#define LOCK_CAPTY 0x10
+
+/**
+ * The syscall can run in a batch: it does not block, yield or switch processes.
+ */
+#define SYSCALL_BATCH 0x20
+
+/**
+ * The syscall returns the amount of work left, and continues in the kernel when preempted.
+ */
+#define SYSCALL_RESUME 0x40
+
+static proc_t *syscall_batch(pid_t pid, word_t args[8]);
+
+/**
+ * Handlers for individual system calls and the locks they need.
+ */
+static const struct {
+	handler_t handler;
+	word_t locks;
+} handlers[] = {
+	{syscall_pid_get, LOCK_NONE | SYSCALL_BATCH},
+	{syscall_vreg_get, LOCK_NONE | SYSCALL_BATCH},
+	{syscall_vreg_set, LOCK_NONE | SYSCALL_BATCH},
+	{syscall_sync, LOCK_NONE},
+	{syscall_sleep_until, LOCK_NONE},
+	{syscall_mem_introspect, LOCK_MEM | SYSCALL_BATCH},
+	{syscall_tsl_introspect, LOCK_TSL | SYSCALL_BATCH},
+	{syscall_mon_introspect, LOCK_MON | SYSCALL_BATCH},
+	{syscall_ipc_introspect, LOCK_IPC | SYSCALL_BATCH},
+	{syscall_mem_derive, LOCK_MEM | SYSCALL_BATCH},
+	{syscall_tsl_derive, LOCK_TSL | SYSCALL_BATCH},
+	{syscall_mon_derive, LOCK_MON | SYSCALL_BATCH},
+	{syscall_ipc_derive, LOCK_IPC | SYSCALL_BATCH},
+	{syscall_mem_revoke, LOCK_MEM | LOCK_IPC | SYSCALL_BATCH | SYSCALL_RESUME},
+	{syscall_tsl_revoke, LOCK_TSL | SYSCALL_BATCH | SYSCALL_RESUME},
+	{syscall_mon_revoke, LOCK_MON | SYSCALL_BATCH | SYSCALL_RESUME},
+	{syscall_ipc_revoke, LOCK_IPC | SYSCALL_BATCH | SYSCALL_RESUME},
+	{syscall_mem_delete, LOCK_MEM | LOCK_IPC | SYSCALL_BATCH},
+	{syscall_tsl_delete, LOCK_TSL | SYSCALL_BATCH},
+	{syscall_mon_delete, LOCK_MON | SYSCALL_BATCH},
+	{syscall_ipc_delete, LOCK_IPC | SYSCALL_BATCH},
+	{syscall_mem_pmp_get, LOCK_MEM | SYSCALL_BATCH},
+	{syscall_mem_pmp_set, LOCK_MEM | SYSCALL_BATCH},
+	{syscall_mem_pmp_clear, LOCK_MEM | SYSCALL_BATCH},
+	{syscall_tsl_set, LOCK_TSL | SYSCALL_BATCH},
+	{syscall_mon_suspend, LOCK_MON | SYSCALL_BATCH},
+	{syscall_mon_resume, LOCK_MON | SYSCALL_BATCH},
+	{syscall_mon_yield, LOCK_MON},
+	{syscall_mon_reg_get, LOCK_MON | SYSCALL_BATCH},
+	{syscall_mon_reg_set, LOCK_MON | SYSCALL_BATCH},
+	{syscall_mon_vreg_get, LOCK_MON | SYSCALL_BATCH},
+	{syscall_mon_vreg_set, LOCK_MON | SYSCALL_BATCH},
+	{syscall_mon_mem_introspect, LOCK_MON | LOCK_MEM | SYSCALL_BATCH},
+	{syscall_mon_tsl_introspect, LOCK_MON | LOCK_TSL | SYSCALL_BATCH},
+	{syscall_mon_mon_introspect, LOCK_MON | SYSCALL_BATCH},
+	{syscall_mon_ipc_introspect, LOCK_MON | LOCK_IPC | SYSCALL_BATCH},
+	{syscall_mon_mem_grant, LOCK_MON | LOCK_MEM | LOCK_IPC | SYSCALL_BATCH},
+	{syscall_mon_tsl_grant, LOCK_MON | LOCK_TSL | SYSCALL_BATCH},
+	{syscall_mon_mon_grant, LOCK_MON | SYSCALL_BATCH},
+	{syscall_mon_ipc_grant, LOCK_MON | LOCK_IPC | SYSCALL_BATCH},
+	{syscall_mon_mem_derive, LOCK_MON | LOCK_MEM | SYSCALL_BATCH},
+	{syscall_mon_tsl_derive, LOCK_MON | LOCK_TSL | SYSCALL_BATCH},
+	{syscall_mon_mon_derive, LOCK_MON | SYSCALL_BATCH},
+	{syscall_mon_ipc_derive, LOCK_MON | LOCK_IPC | SYSCALL_BATCH},
+	{syscall_mon_mem_pmp_get, LOCK_MON | LOCK_MEM | SYSCALL_BATCH},
+	{syscall_mon_mem_pmp_set, LOCK_MON | LOCK_MEM | SYSCALL_BATCH},
+	{syscall_mon_mem_pmp_clear, LOCK_MON | LOCK_MEM | SYSCALL_BATCH},
+	{syscall_mon_tsl_set, LOCK_MON | LOCK_TSL | SYSCALL_BATCH},
+	{syscall_ipc_send, LOCK_MEM | LOCK_IPC | LOCK_CAPTY},
+	{syscall_ipc_recv, LOCK_IPC},
+	{syscall_ipc_call, LOCK_MEM | LOCK_IPC | LOCK_CAPTY},
+	{syscall_ipc_reply, LOCK_MEM | LOCK_IPC | LOCK_CAPTY},
+	{syscall_ipc_replyrecv, LOCK_MEM | LOCK_IPC | LOCK_CAPTY},
+	{syscall_ipc_asend, LOCK_IPC},
+	{syscall_ipc_arecv, LOCK_IPC | SYSCALL_BATCH},
+	{syscall_tsl_slack, LOCK_TSL | SYSCALL_BATCH},
+	{syscall_mon_tsl_slack, LOCK_MON | LOCK_TSL | SYSCALL_BATCH},
+	{syscall_ipc_bind, LOCK_MEM | LOCK_IPC | SYSCALL_BATCH},
+	{syscall_ipc_recv_set, LOCK_IPC},
+	{syscall_irq_bind, LOCK_IPC | SYSCALL_BATCH},
+	{syscall_irq_ack, LOCK_IPC | SYSCALL_BATCH},
+	{syscall_mon_irq_grant, LOCK_MON | LOCK_IPC | SYSCALL_BATCH},
+	{syscall_batch, LOCK_NONE},
+	{syscall_tsl_mode, LOCK_TSL | SYSCALL_BATCH},
+	{syscall_tsl_ticks, LOCK_TSL | SYSCALL_BATCH},
+	{syscall_mon_stats, LOCK_MON | SYSCALL_BATCH},
 };
 
+/**
+ * Get the locks needed by a system call.
+ */
+static lock_set_t _syscall_locks(word_t syscall_nr, word_t args[8])
+{
+	word_t locks = handlers[syscall_nr].locks & ~(SYSCALL_BATCH | SYSCALL_RESUME);
+	if (!(locks & LOCK_CAPTY)) {
+		return locks;
+	}
+
+	// Lock the tables of the transferred capabilities.
+	locks &= ~LOCK_CAPTY;
+	for (word_t capty = args[4]; capty != 0; capty >>= 4) {
+		switch (capty & 0xF) {
+		case CAPTY_MEM:
+			locks |= LOCK_MEM;
+			break;
+		case CAPTY_TSL:
+			locks |= LOCK_TSL;
+			break;
+		case CAPTY_MON:
+			locks |= LOCK_MON;
+			break;
+		case CAPTY_IPC:
+			locks |= LOCK_IPC;
+			break;
+		default:
+			break;
+		}
+	}
+	return locks;
+}
+
+/**
+ * Find the operations of a batch in a readable and writable memory capability of the caller.
+ * Returns NULL if the operations do not lie within the capability.
+ */
+static word_t (*_syscall_batch_ops(pid_t pid, index_t j, word_t offset, word_t count))[8]
+{
+	mem_t mem;
+	lock_acquire(LOCK_MEM, false);
+	int err = mem_introspect(pid, j, 0, &mem);
+	lock_release(LOCK_MEM);
+	if (err != ERR_SUCCESS || (mem.rwx & MEM_PERM_RW) != MEM_PERM_RW) {
+		return NULL;
+	}
+	if (offset > mem.size || offset % sizeof(word_t) != 0 || count > (mem.size - offset) / (8 * sizeof(word_t))) {
+		return NULL;
+	}
+	return (word_t(*)[8])(mem.base + offset);
+}
+
+/**
+ * Run a batch of system calls, each stored as its a0-a7 registers in memory.
+ * Each operation takes its own locks, so the batch stops between operations
+ * when preempted. The number of completed operations is returned in a1.
+ */
+static proc_t *syscall_batch(pid_t pid, word_t args[8])
+{
+	index_t j = args[1];
+	word_t offset = args[2];
+	word_t count = args[3];
+	word_t(*ops)[8] = _syscall_batch_ops(pid, j, offset, count);
+	if (ops == NULL) {
+		args[0] = ERR_INVALID_ACCESS;
+		return current;
+	}
+
+	proc_t *next = current;
+	word_t done = 0;
+	args[0] = ERR_SUCCESS;
+	while (done < count) {
+		word_t op[8];
+		for (int k = 0; k < 8; k++) {
+			op[k] = ops[done][k];
+		}
+		word_t syscall_nr = op[0];
+		if (syscall_nr >= ARRAY_SIZE(handlers) || !(handlers[syscall_nr].locks & SYSCALL_BATCH)) {
+			args[0] = ERR_INVALID_ARGUMENT;
+			break;
+		}
+		// Preemption checkpoint between operations, the caller resumes after the ecall.
+		lock_set_t locks = _syscall_locks(syscall_nr, op);
+		if (!lock_acquire(locks, true)) {
+			next = NULL;
+			break;
+		}
+		handlers[syscall_nr].handler(pid, op);
+		lock_release(locks);
+		// The operation may have revoked the memory of the batch.
+		if ((locks & LOCK_MEM) && _syscall_batch_ops(pid, j, offset, count) != ops) {
+			args[0] = ERR_INVALID_ACCESS;
+			break;
+		}
+		for (int k = 0; k < 8; k++) {
+			ops[done][k] = op[k];
+		}
+		done++;
+	}
+	args[1] = done;
+	return next;
+}
+
+/**
+ * Processes with a deferred system call, bit pid - 1 is set for each.
+ * Idle harts resume these calls while the processes wait for their slots.
+ */
+#define WORD_BITS (8 * sizeof(word_t))
+static word_t deferred[(MAX_PID + WORD_BITS - 1) / WORD_BITS];
+
+/**
+ * Mark or unmark a process as having a deferred system call.
+ */
+static void _syscall_set_deferred(proc_t *proc, bool cont)
+{
+	word_t bit = (word_t)1 << ((proc->pid - 1) % WORD_BITS);
+	word_t *word = &deferred[(proc->pid - 1) / WORD_BITS];
+	proc->cont = cont;
+	if (cont) {
+		__atomic_fetch_or(word, bit, __ATOMIC_RELAXED);
+	} else {
+		__atomic_fetch_and(word, ~bit, __ATOMIC_RELAXED);
+	}
+}
+
+/**
+ * Defer a resumable system call that was preempted with work left.
+ * Its registers hold the call again, and the kernel resumes it before the process runs.
+ */
+static bool _syscall_defer(proc_t *proc, word_t syscall_nr)
+{
+	word_t *args = &proc->regs.a0;
+	if (!(handlers[syscall_nr].locks & SYSCALL_RESUME) || (long)args[0] <= 0 || !preempt()) {
+		return false;
+	}
+	args[0] = syscall_nr;
+	_syscall_set_deferred(proc, true);
+	return true;
+}
+
+/**
+ * Resume the deferred system call of a process.
+ */
+bool syscall_resume(proc_t *proc)
+{
+	word_t syscall_nr = proc->regs.a0;
+	// A monitor may have rewritten the registers while the process waited.
+	if (syscall_nr >= ARRAY_SIZE(handlers) || !(handlers[syscall_nr].locks & SYSCALL_RESUME)) {
+		_syscall_set_deferred(proc, false);
+		return true;
+	}
+	lock_set_t locks = _syscall_locks(syscall_nr, &proc->regs.a0);
+	if (!lock_acquire(locks, true)) {
+		return false;
+	}
+	handlers[syscall_nr].handler(proc->pid, &proc->regs.a0);
+	lock_release(locks);
+	if (_syscall_defer(proc, syscall_nr)) {
+		return false;
+	}
+	_syscall_set_deferred(proc, false);
+	return true;
+}
+
+/**
+ * Resume deferred system calls of processes that are not running.
+ */
+bool syscall_resume_deferred(void)
+{
+	bool finished = false;
+	for (pid_t pid = 1; pid <= MAX_PID && !preempt(); pid++) {
+		word_t bit = (word_t)1 << ((pid - 1) % WORD_BITS);
+		if (!(__atomic_load_n(&deferred[(pid - 1) / WORD_BITS], __ATOMIC_RELAXED) & bit)) {
+			continue;
+		}
+		// Fails if the process runs, is suspended or another hart resumes it.
+		if (!proc_acquire(pid)) {
+			continue;
+		}
+		proc_t *proc = proc_get(pid);
+		bool done = !proc->cont || syscall_resume(proc);
+		proc_release(pid);
+		if (done) {
+			// The process may own the current frame of another hart.
+			sched_wake(pid);
+			finished = true;
+		}
+	}
+	return finished;
+}
+
+/**
+ * Fast path of yielding IPC calls and reply-receives without capability transfer
+ * whose partner already waits. Skips the handler table and takes only the locks it needs.
+ * Returns false without side effects if the fast path does not apply.
+ */
+static bool _syscall_ipc_fast(word_t syscall_nr, proc_t **next)
+{
+	word_t *args = &current->regs.a0;
+	bool call = handlers[syscall_nr].handler == syscall_ipc_call;
+	if ((!call && handlers[syscall_nr].handler != syscall_ipc_replyrecv) || args[4] != CAPTY_NONE) {
+		return false;
+	}
+
+	lock_set_t locks = ipc_fast_locks(args[1]);
+	if (!lock_acquire(locks, true)) {
+		return false;
+	}
+	word_t data[2] = {args[2], args[3]};
+	*next = current;
+	bool done = call ? ipc_call_fast(current->pid, args[1], data, next, args[6], locks)
+			 : ipc_replyrecv_fast(current->pid, args[1], data, next, args[6], args[7], locks);
+	if (done) {
+		// A call returns with the reply, which overwrites a0.
+		args[0] = call ? ERR_TIMEOUT : ERR_SUCCESS;
+		current->regs.pc += 4;
+	}
+	lock_release(locks);
+	return done;
+}
+
 /**
  * System call handler.
  */
@@ -733,8 +1090,14 @@ proc_t *syscall_handler(void)
 		return exception_handler(0x8, syscall_nr);
 	}
 
-	// Try to acquire a lock. Also checks for preemption.
-	if (!lock_acquire(true)) {
+	proc_t *next;
+	if (_syscall_ipc_fast(syscall_nr, &next)) {
+		return next;
+	}
+
+	// Try to acquire the locks of the system call. Also checks for preemption.
+	lock_set_t locks = _syscall_locks(syscall_nr, &current->regs.a0);
+	if (!lock_acquire(locks, true)) {
 		return NULL;
 	}
 
@@ -742,10 +1105,14 @@ proc_t *syscall_handler(void)
 	current->regs.pc += 4;
 
 	// Call the system call handler
-	proc_t *next = handlers[syscall_nr](current->pid, &current->regs.a0);
+	next = handlers[syscall_nr].handler(current->pid, &current->regs.a0);
 
-	// Releases the lock.
-	lock_release();
+	// Releases the locks.
+	lock_release(locks);
 
+	// A preempted revocation continues in the kernel, the process waits for it.
+	if (_syscall_defer(current, syscall_nr)) {
+		return NULL;
+	}
 	return next;
 }
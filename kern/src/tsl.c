@@ -15,17 +15,18 @@ static tsl_t tsl_table[TSL_TABLE_SIZE];
  */
 void tsl_init()
 {
-	// Create an initial time slice capability for each hardware thread.
-	for (int i = 0; i < NUM_HARTS; ++i) {
+	// Create an initial time slice capability for each hardware thread and schedule mode.
+	for (int i = 0; i < NUM_HARTS * NUM_SCHED_MODES; ++i) {
 		tsl_table[i * MAX_TIME_FUEL] = (tsl_t){
 			.owner = 1,
 			.base = 0,
-			.hart = i,
+			.hart = i / NUM_SCHED_MODES,
+			.mode = i % NUM_SCHED_MODES,
 			.cfree = MAX_TIME_FUEL,
 			.csize = MAX_TIME_FUEL,
 			.free = MAX_TIME_SLOT,
 			.size = MAX_TIME_SLOT,
-			.enabled = (i == 0) // Enable the first hart by default.,
+			.enabled = (i == 0) // Enable the first hart in mode 0 by default.,
 		};
 	}
 }
@@ -46,6 +47,17 @@ static bool _derivable(tsl_t parent, fuel_t csize, time_slot_t size)
 	return parent.cfree > csize && size <= parent.free && csize > 0 && size > 0;
 }
 
+/**
+ * Stops a time slice capability from donating its idle time.
+ */
+static void _slack_clear(tsl_t *cap)
+{
+	if (cap->slack) {
+		cap->slack = false;
+		sched_set_slack(cap->hart, cap->mode, INVALID_PID, 0, 0);
+	}
+}
+
 /**
  * Transfers a time slice capability from one process to another.
  */
@@ -58,9 +70,13 @@ int tsl_transfer(pid_t owner, index_t i, pid_t new_owner)
 	// Update the owner of the capability.
 	tsl_table[i].owner = new_owner;
 
+	// The new owner decides where idle time goes.
+	_slack_clear(&tsl_table[i]);
+
 	// Update the scheduler if the capability is enabled.
 	if (tsl_table[i].free > 0) {
-		sched_set_pid(tsl_table[i].hart, tsl_table[i].enabled ? new_owner : INVALID_PID, tsl_table[i].base);
+		sched_set_pid(tsl_table[i].hart, tsl_table[i].mode, tsl_table[i].enabled ? new_owner : INVALID_PID,
+			      tsl_table[i].base);
 	}
 
 	return ERR_SUCCESS;
@@ -109,6 +125,7 @@ int tsl_derive(pid_t owner, index_t i, pid_t target, fuel_t csize, bool enable,
 		.cfree = csize,
 		.csize = csize,
 		.hart = tsl_table[i].hart,
+		.mode = tsl_table[i].mode,
 		.enabled = enable,
 		.base = base,
 		.size = size,
@@ -117,7 +134,7 @@ int tsl_derive(pid_t owner, index_t i, pid_t target, fuel_t csize, bool enable,
 
 	// Update the scheduler with the new capability.
 	pid_t sched_pid = enable ? target : INVALID_PID;
-	sched_split(tsl_table[i].hart, sched_pid, tsl_table[i].base, base, base + size);
+	sched_split(tsl_table[i].hart, tsl_table[i].mode, sched_pid, tsl_table[i].base, base, base + size);
 
 	// Return the index of the new capability.
 	return j;
@@ -142,6 +159,7 @@ int tsl_revoke(pid_t owner, index_t i)
 
 		// Invalidate the child capability.
 		tsl_table[j].owner = INVALID_PID;
+		_slack_clear(&tsl_table[j]);
 
 		if (UNLIKELY(preempt()))
 			break;
@@ -149,7 +167,7 @@ int tsl_revoke(pid_t owner, index_t i)
 
 	// Reclaim allocated time slots in the scheduler.
 	pid_t pid = tsl_table[i].enabled ? owner : INVALID_PID;
-	sched_reclaim(tsl_table[i].hart, pid, tsl_table[i].base, tsl_table[i].base + tsl_table[i].free);
+	sched_reclaim(tsl_table[i].hart, tsl_table[i].mode, pid, tsl_table[i].base, tsl_table[i].base + tsl_table[i].free);
 
 	// Return the remaining cfree to be revoked.
 	// Is 0 if all children are revoked.
@@ -167,10 +185,11 @@ int tsl_delete(pid_t owner, index_t i)
 
 	// Invalidates the capability.
 	tsl_table[i].owner = INVALID_PID;
+	_slack_clear(&tsl_table[i]);
 
 	// Deletes the minor frame in the scheduler.
 	if (tsl_table[i].free > 0) {
-		sched_set_pid(tsl_table[i].hart, INVALID_PID, tsl_table[i].base);
+		sched_set_pid(tsl_table[i].hart, tsl_table[i].mode, INVALID_PID, tsl_table[i].base);
 	}
 
 	return ERR_SUCCESS;
@@ -188,10 +207,75 @@ int tsl_set(pid_t owner, index_t i, bool enable)
 	// Enable or disable the minor frame in the scheduler.
 	if (tsl_table[i].free > 0) {
 		pid_t sched_pid = enable ? owner : INVALID_PID;
-		sched_set_pid(tsl_table[i].hart, sched_pid, tsl_table[i].base);
+		sched_set_pid(tsl_table[i].hart, tsl_table[i].mode, sched_pid, tsl_table[i].base);
 	}
 	// Make the time slice capability enabled or disabled.
 	tsl_table[i].enabled = enable;
 
 	return ERR_SUCCESS;
 }
+
+/**
+ * Donates the idle time of a time slice capability to a process.
+ */
+int tsl_slack(pid_t owner, index_t i, pid_t pid)
+{
+	if (UNLIKELY(!tsl_valid_access(owner, i))) {
+		return ERR_INVALID_ACCESS;
+	}
+
+	if (pid == INVALID_PID) {
+		_slack_clear(&tsl_table[i]);
+		return ERR_SUCCESS;
+	}
+
+	// Only one capability per hart may donate idle time.
+	if (!tsl_table[i].slack && sched_get_slack(tsl_table[i].hart) != INVALID_PID) {
+		return ERR_SLOT_IN_USE;
+	}
+
+	// Donate the idle time of all slots in the capability's range.
+	tsl_table[i].slack = true;
+	sched_set_slack(tsl_table[i].hart, tsl_table[i].mode, pid, tsl_table[i].base,
+			tsl_table[i].base + tsl_table[i].size);
+
+	return ERR_SUCCESS;
+}
+
+/**
+ * Switches the hart of a time slice capability to its schedule mode.
+ */
+int tsl_mode(pid_t owner, index_t i)
+{
+	if (UNLIKELY(!tsl_valid_access(owner, i))) {
+		return ERR_INVALID_ACCESS;
+	}
+
+	// Only a capability covering the whole major frame may select the mode.
+	if (tsl_table[i].base != 0 || tsl_table[i].size != MAX_TIME_SLOT) {
+		return ERR_INVALID_ARGUMENT;
+	}
+
+	sched_set_mode(tsl_table[i].hart, tsl_table[i].mode);
+
+	return ERR_SUCCESS;
+}
+
+/**
+ * Sets the length in ticks of a slot in the schedule mode of a time slice capability.
+ */
+int tsl_ticks(pid_t owner, index_t i, time_slot_t slot, uint32_t ticks)
+{
+	if (UNLIKELY(!tsl_valid_access(owner, i))) {
+		return ERR_INVALID_ACCESS;
+	}
+
+	// Slot lengths shift every later frame, so only a capability covering the whole major frame may set them.
+	if (tsl_table[i].base != 0 || tsl_table[i].size != MAX_TIME_SLOT || slot >= MAX_TIME_SLOT || ticks == 0) {
+		return ERR_INVALID_ARGUMENT;
+	}
+
+	sched_set_ticks(tsl_table[i].hart, tsl_table[i].mode, slot, ticks);
+
+	return ERR_SUCCESS;
+}
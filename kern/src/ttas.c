@@ -10,9 +10,12 @@ void ttas_init(ttas_t *ttas)
 bool ttas_acquire(ttas_t *ttas, bool preemptable)
 {
 	while (__atomic_exchange_n(&ttas->lock, 1, __ATOMIC_ACQUIRE)) {
-		if (preemptable && preempt()) {
-			return false;
-		}
+		// Spin on a plain load until the lock looks free, then retry the exchange.
+		do {
+			if (preemptable && preempt()) {
+				return false;
+			}
+		} while (__atomic_load_n(&ttas->lock, __ATOMIC_RELAXED));
 	}
 	return true;
 }
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "s3k/syscall.h"
+#include "s3k/types.h"
+
+/**
+ * @struct s3k_ring
+ * @brief Single-producer single-consumer ring of words in shared memory.
+ *
+ * The producer only writes `tail` and the consumer only writes `head`, so
+ * messages are exchanged without system calls. The kernel is only entered
+ * to wake a consumer that waits on an empty ring, using an asynchronous
+ * IPC channel from the producer to the consumer.
+ */
+typedef struct s3k_ring {
+	uint32_t head;	  ///< Index of the next entry to pop, written by the consumer.
+	uint32_t tail;	  ///< Index of the next entry to push, written by the producer.
+	uint32_t waiting; ///< Set by the consumer before it waits for a wakeup.
+	uint32_t mask;	  ///< Capacity minus one, the capacity is a power of two.
+	s3k_word_t buf[]; ///< Entries.
+} s3k_ring_t;
+
+/**
+ * Initialize a ring with `capacity` entries; `capacity` must be a power of two.
+ * The memory at `ring` must hold `sizeof(s3k_ring_t) + capacity * sizeof(s3k_word_t)` bytes.
+ */
+static inline bool s3k_ring_init(s3k_ring_t *ring, uint32_t capacity)
+{
+	if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+		return false;
+	ring->head = 0;
+	ring->tail = 0;
+	ring->waiting = 0;
+	ring->mask = capacity - 1;
+	return true;
+}
+
+/**
+ * Number of entries in the ring.
+ */
+static inline uint32_t s3k_ring_count(const s3k_ring_t *ring)
+{
+	return __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Push an entry without waking the consumer. Returns false if the ring is full.
+ */
+static inline bool s3k_ring_push(s3k_ring_t *ring, s3k_word_t msg)
+{
+	uint32_t tail = ring->tail;
+	if (tail - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) > ring->mask)
+		return false;
+	ring->buf[tail & ring->mask] = msg;
+	__atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+/**
+ * Pop an entry without waiting. Returns false if the ring is empty.
+ */
+static inline bool s3k_ring_pop(s3k_ring_t *ring, s3k_word_t *msg)
+{
+	uint32_t head = ring->head;
+	if (head == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE))
+		return false;
+	*msg = ring->buf[head & ring->mask];
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+/**
+ * Push an entry and wake the consumer if it waits for one.
+ * `i` is the source capability of an asynchronous IPC channel to the consumer.
+ * Returns S3K_ERR_SLOTUSE if the ring is full.
+ */
+static inline int s3k_ring_send(s3k_ring_t *ring, s3k_index_t i, s3k_word_t msg)
+{
+	if (!s3k_ring_push(ring, msg))
+		return S3K_ERR_SLOTUSE;
+	// Order the push before reading `waiting`, pairs with the fence in s3k_ring_recv.
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&ring->waiting, __ATOMIC_RELAXED) && __atomic_exchange_n(&ring->waiting, 0, __ATOMIC_RELAXED))
+		return s3k_ipc_asend(i, 0);
+	return S3K_SUCCESS;
+}
+
+/**
+ * Pop an entry, waiting for the producer if the ring is empty.
+ * `i` is the sink capability of an asynchronous IPC channel from the producer.
+ */
+static inline int s3k_ring_recv(s3k_ring_t *ring, s3k_index_t i, s3k_word_t *msg)
+{
+	while (!s3k_ring_pop(ring, msg)) {
+		__atomic_store_n(&ring->waiting, 1, __ATOMIC_RELAXED);
+		// Order setting `waiting` before the last check, pairs with the fence in s3k_ring_send.
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if (s3k_ring_pop(ring, msg)) {
+			__atomic_store_n(&ring->waiting, 0, __ATOMIC_RELAXED);
+			return S3K_SUCCESS;
+		}
+		// The kernel keeps a wakeup sent before this call pending, so none is lost.
+		s3k_msg_t wakeup = {0};
+		int err = s3k_ipc_recv(i, &wakeup);
+		if (err)
+			return err;
+	}
+	return S3K_SUCCESS;
+}
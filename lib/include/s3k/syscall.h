@@ -57,6 +57,17 @@ enum {
 	S3K_SYSCALL_IPC_REPLYRECV,
 	S3K_SYSCALL_IPC_ASEND,
 	S3K_SYSCALL_IPC_ARECV,
+	S3K_SYSCALL_TSL_SLACK,
+	S3K_SYSCALL_MON_TSL_SLACK,
+	S3K_SYSCALL_IPC_BIND,
+	S3K_SYSCALL_IPC_RECV_SET,
+	S3K_SYSCALL_IRQ_BIND,
+	S3K_SYSCALL_IRQ_ACK,
+	S3K_SYSCALL_MON_IRQ_GRANT,
+	S3K_SYSCALL_BATCH,
+	S3K_SYSCALL_TSL_MODE,
+	S3K_SYSCALL_TSL_TICKS,
+	S3K_SYSCALL_MON_STATS,
 };
 
 static inline s3k_pid_t s3k_pid_get(void)
@@ -610,14 +621,14 @@ static inline int s3k_ipc_recv(s3k_index_t i, s3k_msg_t *msg)
 	register s3k_word_t a0 __asm__("a0") = S3K_SYSCALL_IPC_RECV;
 	register s3k_word_t a1 __asm__("a1") = i;
 	register s3k_word_t a2 __asm__("a2") = msg->servtime;
-	register s3k_word_t a3 __asm__("a3");
+	register s3k_word_t a3 __asm__("a3") = msg->deadline;
 	register s3k_word_t a4 __asm__("a4");
-	__asm__ volatile("ecall" : "+r"(a0), "+r"(a1), "+r"(a2), "=r"(a3), "=r"(a4));
+	__asm__ volatile("ecall" : "+r"(a0), "+r"(a1), "+r"(a2), "+r"(a3), "=r"(a4));
 	if (a0 == S3K_SUCCESS) {
 		msg->data[0] = a1;
 		msg->data[1] = a2;
-		msg->capty = (s3k_capty_t)a3;
-		msg->capidx = (s3k_index_t)a4;
+		msg->capty = a3;
+		msg->capidx = a4;
 	}
 	return a0;
 }
@@ -630,12 +641,13 @@ static inline int s3k_ipc_call(s3k_index_t i, s3k_msg_t *msg)
 	register s3k_word_t a3 __asm__("a3") = msg->data[1];
 	register s3k_word_t a4 __asm__("a4") = msg->capty;
 	register s3k_word_t a5 __asm__("a5") = msg->capidx;
-	__asm__ volatile("ecall" : "+r"(a0), "+r"(a1), "+r"(a2), "+r"(a3), "+r"(a4) : "r"(a5));
+	register s3k_word_t a6 __asm__("a6") = msg->deadline;
+	__asm__ volatile("ecall" : "+r"(a0), "+r"(a1), "+r"(a2), "+r"(a3), "+r"(a4) : "r"(a5), "r"(a6));
 	if (a0 == S3K_SUCCESS) {
 		msg->data[0] = a1;
 		msg->data[1] = a2;
-		msg->capty = (s3k_capty_t)a3;
-		msg->capidx = (s3k_index_t)a4;
+		msg->capty = a3;
+		msg->capidx = a4;
 	}
 	return a0;
 }
@@ -661,12 +673,13 @@ static inline int s3k_ipc_replyrecv(s3k_index_t i, s3k_msg_t *msg)
 	register s3k_word_t a4 __asm__("a4") = msg->capty;
 	register s3k_word_t a5 __asm__("a5") = msg->capidx;
 	register s3k_word_t a6 __asm__("a6") = msg->servtime;
-	__asm__ volatile("ecall" : "+r"(a0), "+r"(a1), "+r"(a2), "+r"(a3), "+r"(a4) : "r"(a5), "r"(a6));
+	register s3k_word_t a7 __asm__("a7") = msg->deadline;
+	__asm__ volatile("ecall" : "+r"(a0), "+r"(a1), "+r"(a2), "+r"(a3), "+r"(a4) : "r"(a5), "r"(a6), "r"(a7));
 	if (a0 == S3K_SUCCESS) {
 		msg->data[0] = a1;
 		msg->data[1] = a2;
-		msg->capty = (s3k_capty_t)a3;
-		msg->capidx = (s3k_index_t)a4;
+		msg->capty = a3;
+		msg->capidx = a4;
 	}
 	return a0;
 }
@@ -688,3 +701,165 @@ static inline int s3k_ipc_arecv(s3k_index_t i, s3k_word_t *msg)
 	*msg = a1;
 	return a0;
 }
+
+static inline int s3k_ipc_notify(s3k_index_t i, uint32_t bits)
+{
+	return s3k_ipc_asend(i, bits);
+}
+
+static inline int s3k_ipc_wait(s3k_index_t i, uint32_t mask, uint32_t *bits)
+{
+	register s3k_word_t a0 __asm__("a0") = S3K_SYSCALL_IPC_RECV;
+	register s3k_word_t a1 __asm__("a1") = i;
+	register s3k_word_t a2 __asm__("a2") = mask;
+	register s3k_word_t a3 __asm__("a3");
+	register s3k_word_t a4 __asm__("a4");
+	__asm__ volatile("ecall" : "+r"(a0), "+r"(a1), "+r"(a2), "=r"(a3), "=r"(a4));
+	if (a0 == S3K_SUCCESS)
+		*bits = a1;
+	return a0;
+}
+
+static inline int s3k_tsl_slack(s3k_index_t i, bool enabled)
+{
+	register s3k_word_t a0 __asm__("a0") = S3K_SYSCALL_TSL_SLACK;
+	register s3k_word_t a1 __asm__("a1") = i;
+	register s3k_word_t a2 __asm__("a2") = enabled;
+	__asm__ volatile("ecall" : "+r"(a0) : "r"(a1), "r"(a2));
+	return a0;
+}
+
+static inline int s3k_mon_tsl_slack(s3k_index_t i, s3k_index_t j, bool enabled)
+{
+	register s3k_word_t a0 __asm__("a0") = S3K_SYSCALL_MON_TSL_SLACK;
+	register s3k_word_t a1 __asm__("a1") = i;
+	register s3k_word_t a2 __asm__("a2") = j;
+	register s3k_word_t a3 __asm__("a3") = enabled;
+	__asm__ volatile("ecall" : "+r"(a0) : "r"(a1), "r"(a2), "r"(a3));
+	return a0;
+}
+
+static inline int s3k_ipc_bind(s3k_index_t i, s3k_index_t j)
+{
+	register s3k_word_t a0 __asm__("a0") = S3K_SYSCALL_IPC_BIND;
+	register s3k_word_t a1 __asm__("a1") = i;
+	register s3k_word_t a2 __asm__("a2") = j;
+	register s3k_word_t a3 __asm__("a3") = true;
+	__asm__ volatile("ecall" : "+r"(a0) : "r"(a1), "r"(a2), "r"(a3));
+	return a0;
+}
+
+static inline int s3k_ipc_unbind(s3k_index_t i)
+{
+	register s3k_word_t a0 __asm__("a0") = S3K_SYSCALL_IPC_BIND;
+	register s3k_word_t a1 __asm__("a1") = i;
+	register s3k_word_t a2 __asm__("a2") = 0;
+	register s3k_word_t a3 __asm__("a3") = false;
+	__asm__ volatile("ecall" : "+r"(a0) : "r"(a1), "r"(a2), "r"(a3));
+	return a0;
+}
+
+static inline int s3k_ipc_recv_set(s3k_index_t base, s3k_word_t mask, s3k_msg_t *msg, s3k_index_t *fired)
+{
+	register s3k_word_t a0 __asm__("a0") = S3K_SYSCALL_IPC_RECV_SET;
+	register s3k_word_t a1 __asm__("a1") = base;
+	register s3k_word_t a2 __asm__("a2") = mask;
+	register s3k_word_t a3 __asm__("a3") = msg->servtime;
+	register s3k_word_t a4 __asm__("a4") = msg->deadline;
+	register s3k_word_t a5 __asm__("a5");
+	__asm__ volatile("ecall" : "+r"(a0), "+r"(a1), "+r"(a2), "+r"(a3), "+r"(a4), "=r"(a5));
+	if (a0 == S3K_SUCCESS) {
+		msg->data[0] = a1;
+		msg->data[1] = a2;
+		msg->capty = a3;
+		msg->capidx = a4;
+		*fired = a5;
+	}
+	return a0;
+}
+
+static inline int s3k_irq_bind(s3k_index_t irq, s3k_index_t i, s3k_word_t data)
+{
+	register s3k_word_t a0 __asm__("a0") = S3K_SYSCALL_IRQ_BIND;
+	register s3k_word_t a1 __asm__("a1") = irq;
+	register s3k_word_t a2 __asm__("a2") = i;
+	register s3k_word_t a3 __asm__("a3") = data;
+	register s3k_word_t a4 __asm__("a4") = true;
+	__asm__ volatile("ecall" : "+r"(a0) : "r"(a1), "r"(a2), "r"(a3), "r"(a4));
+	return a0;
+}
+
+static inline int s3k_irq_unbind(s3k_index_t irq)
+{
+	register s3k_word_t a0 __asm__("a0") = S3K_SYSCALL_IRQ_BIND;
+	register s3k_word_t a1 __asm__("a1") = irq;
+	register s3k_word_t a2 __asm__("a2") = 0;
+	register s3k_word_t a3 __asm__("a3") = 0;
+	register s3k_word_t a4 __asm__("a4") = false;
+	__asm__ volatile("ecall" : "+r"(a0) : "r"(a1), "r"(a2), "r"(a3), "r"(a4));
+	return a0;
+}
+
+static inline int s3k_irq_ack(s3k_index_t irq)
+{
+	register s3k_word_t a0 __asm__("a0") = S3K_SYSCALL_IRQ_ACK;
+	register s3k_word_t a1 __asm__("a1") = irq;
+	__asm__ volatile("ecall" : "+r"(a0) : "r"(a1));
+	return a0;
+}
+
+static inline int s3k_mon_irq_grant(s3k_index_t i, s3k_index_t irq)
+{
+	register s3k_word_t a0 __asm__("a0") = S3K_SYSCALL_MON_IRQ_GRANT;
+	register s3k_word_t a1 __asm__("a1") = i;
+	register s3k_word_t a2 __asm__("a2") = irq;
+	__asm__ volatile("ecall" : "+r"(a0) : "r"(a1), "r"(a2));
+	return a0;
+}
+
+static inline int s3k_batch(s3k_index_t j, s3k_word_t offset, s3k_word_t count, s3k_word_t *done)
+{
+	register s3k_word_t a0 __asm__("a0") = S3K_SYSCALL_BATCH;
+	register s3k_word_t a1 __asm__("a1") = j;
+	register s3k_word_t a2 __asm__("a2") = offset;
+	register s3k_word_t a3 __asm__("a3") = count;
+	__asm__ volatile("ecall" : "+r"(a0), "+r"(a1) : "r"(a2), "r"(a3) : "memory");
+	*done = a1;
+	return a0;
+}
+
+static inline int s3k_tsl_mode(s3k_index_t i)
+{
+	register s3k_word_t a0 __asm__("a0") = S3K_SYSCALL_TSL_MODE;
+	register s3k_word_t a1 __asm__("a1") = i;
+	__asm__ volatile("ecall" : "+r"(a0) : "r"(a1));
+	return a0;
+}
+
+static inline int s3k_tsl_ticks(s3k_index_t i, s3k_time_slot_t slot, uint32_t ticks)
+{
+	register s3k_word_t a0 __asm__("a0") = S3K_SYSCALL_TSL_TICKS;
+	register s3k_word_t a1 __asm__("a1") = i;
+	register s3k_word_t a2 __asm__("a2") = slot;
+	register s3k_word_t a3 __asm__("a3") = ticks;
+	__asm__ volatile("ecall" : "+r"(a0) : "r"(a1), "r"(a2), "r"(a3));
+	return a0;
+}
+
+static inline int s3k_mon_stats(s3k_index_t i, s3k_proc_stats_t *stats)
+{
+	register s3k_word_t a0 __asm__("a0") = S3K_SYSCALL_MON_STATS;
+	register s3k_word_t a1 __asm__("a1") = i;
+	register s3k_word_t a2 __asm__("a2");
+	register s3k_word_t a3 __asm__("a3");
+	register s3k_word_t a4 __asm__("a4");
+	register s3k_word_t a5 __asm__("a5");
+	register s3k_word_t a6 __asm__("a6");
+	__asm__ volatile("ecall" : "+r"(a0), "+r"(a1), "=r"(a2), "=r"(a3), "=r"(a4), "=r"(a5), "=r"(a6));
+	if (a0 == S3K_SUCCESS) {
+		// The figures are returned word by word, 4 words on RV64 and 6 on RV32.
+		s3k_word_t words[] = {a1, a2, a3, a4, a5, a6};
+		__builtin_memcpy(stats, words, sizeof(*stats));
+	}
+	return a0;
+}
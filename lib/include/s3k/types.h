@@ -46,7 +46,8 @@ enum s3k_ipc_mode {
 	S3K_IPC_MODE_USYNC = 1,	 ///< Unidirectional synchronous IPC mode.
 	S3K_IPC_MODE_BSYNC = 2,	 ///< Bidirectional synchronous IPC mode.
 	S3K_IPC_MODE_ASYNC = 3,	 ///< Asynchronous IPC mode.
-	S3K_IPC_MODE_REVOKE = 4, ///< Revoke flag for IPC.
+	S3K_IPC_MODE_NOTIFY = 4, ///< Notification IPC mode.
+	S3K_IPC_MODE_REVOKE = 8, ///< Revoke flag for IPC.
 };
 
 enum s3k_ipc_flag {
@@ -135,13 +136,41 @@ typedef enum s3k_vreg {
 	S3K_VREG_ESP = 5,    ///< Exception Stack Pointer register.
 } s3k_vreg_t;
 
+/**
+ * Accounting figures of a process, see s3k_mon_stats.
+ */
+typedef struct s3k_proc_stats {
+	s3k_time_t runtime;	///< Time in ticks the process has run, including its system calls.
+	s3k_time_t donated;	///< Part of runtime on time handed over by another process.
+	s3k_word_t switches;	///< Number of times the process was dispatched on a hart.
+	s3k_word_t preemptions; ///< Number of times an interrupt took the hart from the process.
+} s3k_proc_stats_t;
+
+/**
+ * Maximum number of capabilities transferred by one IPC message.
+ */
+#define S3K_IPC_MAX_CAPS (sizeof(s3k_word_t) / sizeof(uint16_t))
+
 typedef struct s3k_msg {
-	s3k_word_t data[2]; ///< Data payload (4 words).
-	s3k_capty_t capty;  ///< Capability type.
-	s3k_index_t capidx; ///< Capability index.
-	uint32_t servtime;  ///< Service time.
+	s3k_word_t data[2];  ///< Data payload (4 words).
+	s3k_word_t capty;    ///< Capability types, 4 bits each, see s3k_msg_add_cap.
+	s3k_word_t capidx;   ///< Capability indices, 16 bits each.
+	uint32_t servtime;   ///< Service time.
+	s3k_time_t deadline; ///< Absolute deadline of a blocking call or receive, 0 waits forever.
 } __attribute__((aligned(16))) s3k_msg_t;
 
+/**
+ * @struct s3k_batch_op
+ * @brief One system call of a batch.
+ *
+ * Holds the a0-a7 registers of the system call: the system call number
+ * followed by its arguments. The kernel writes the result registers back,
+ * so `args[0]` holds the error code of the operation.
+ */
+typedef struct s3k_batch_op {
+	s3k_word_t args[8]; ///< System call number and arguments, results after the batch.
+} s3k_batch_op_t;
+
 /**
  * @struct s3k_cap_memory
  * @brief Memory capability structure.
@@ -177,6 +206,8 @@ typedef struct s3k_cap_tsl {
 	s3k_time_slot_t mark;  ///< Start of allocated time slots.
 	s3k_time_slot_t begin; ///< Start address of the time slots.
 	s3k_time_slot_t end;   ///< End address of the time slots.
+	bool slack;	       ///< If the time slots donate their idle time.
+	uint8_t mode;	       ///< The schedule mode of the time slots.
 } __attribute__((aligned(16))) s3k_cap_tsl_t;
 
 typedef struct s3k_cap_mon {
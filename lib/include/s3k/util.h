@@ -16,3 +16,44 @@ static inline s3k_word_t s3k_pmp_napot_decode_size(uint64_t addr)
 {
 	return (((addr + 1) ^ addr) + 1) << 2;
 }
+
+/**
+ * Number of capabilities in an IPC message.
+ */
+static inline unsigned s3k_msg_ncaps(const s3k_msg_t *msg)
+{
+	unsigned k = 0;
+	while (k < S3K_IPC_MAX_CAPS && ((msg->capty >> (4 * k)) & 0xF) != S3K_CAPTY_NONE)
+		k++;
+	return k;
+}
+
+/**
+ * Type of the k-th capability in an IPC message.
+ */
+static inline s3k_capty_t s3k_msg_capty(const s3k_msg_t *msg, unsigned k)
+{
+	return (s3k_capty_t)((msg->capty >> (4 * k)) & 0xF);
+}
+
+/**
+ * Index of the k-th capability in an IPC message.
+ */
+static inline s3k_index_t s3k_msg_capidx(const s3k_msg_t *msg, unsigned k)
+{
+	return (msg->capidx >> (16 * k)) & 0xFFFF;
+}
+
+/**
+ * Append a capability to an IPC message. Returns false if the message is full.
+ * All capabilities of a message are transferred together, or none is.
+ */
+static inline bool s3k_msg_add_cap(s3k_msg_t *msg, s3k_capty_t capty, s3k_index_t i)
+{
+	unsigned k = s3k_msg_ncaps(msg);
+	if (k == S3K_IPC_MAX_CAPS)
+		return false;
+	msg->capty |= (s3k_word_t)capty << (4 * k);
+	msg->capidx = (msg->capidx & ~((s3k_word_t)0xFFFF << (16 * k))) | ((s3k_word_t)(i & 0xFFFF) << (16 * k));
+	return true;
+}
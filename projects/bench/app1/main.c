@@ -0,0 +1,113 @@
+#include "s3k.h"
+
+#include <stdio.h>
+
+#define ITERATIONS 100 // Syscalls measured per time slot
+#define ROUNDS 10      // Time slots measured per configuration
+
+// Must match the nmonitorfuel and ntimefuel options
+#define MONITOR_FUEL 8
+#define TIME_FUEL 32
+
+// Memory of the contenders, shared code with one stack each
+#define APP2_BASE 0x80020000
+#define APP2_SIZE 0x10000
+#define STACK_SIZE 0x1000
+
+// Read the current cycle counter using the RISC-V rdcycle instruction
+uint64_t rdcycle(void)
+{
+	s3k_word_t cycle;
+	__asm__ volatile("rdcycle %0" : "=r"(cycle));
+	return cycle;
+}
+
+// Set up process pid as a contender on hart pid - 1.
+// Returns the monitor capability of the contender, or -1 if the hart does not exist.
+int contender_init(s3k_pid_t pid)
+{
+	int mon = (pid - 1) * MONITOR_FUEL;
+	int tsl = (pid - 1) * TIME_FUEL;
+
+	// Give the contender the time slots of its hart
+	if (s3k_mon_tsl_grant(mon, tsl) != 0)
+		return -1;
+	s3k_mon_tsl_set(mon, tsl, true);
+
+	// Give the contender access to its code and stack
+	int mem = s3k_mon_mem_derive(mon, 0, 1, S3K_MEM_PERM_RWX, APP2_BASE, APP2_SIZE);
+	if (mem < 0)
+		return -1;
+	s3k_mon_mem_pmp_set(mon, mem, 1, S3K_MEM_PERM_RWX, s3k_pmp_napot_encode(APP2_BASE, APP2_SIZE));
+
+	s3k_mon_reg_set(mon, S3K_REG_PC, APP2_BASE);
+	s3k_mon_reg_set(mon, S3K_REG_SP, APP2_BASE + APP2_SIZE - (pid - 2) * STACK_SIZE);
+	return mon;
+}
+
+// Measure the syscall latency in cycles of a syscall taking the kernel lock
+void measure(int contenders)
+{
+	uint64_t min = UINT64_MAX, max = 0, sum = 0;
+	s3k_cap_mem_t cap;
+
+	for (int r = 0; r < ROUNDS; ++r) {
+		s3k_sleep_until(0); // Synchronize to the next time slot
+		for (int i = 0; i < ITERATIONS; ++i) {
+			uint64_t start = rdcycle();
+			s3k_mem_get(0, &cap);
+			uint64_t cycles = rdcycle() - start;
+			min = cycles < min ? cycles : min;
+			max = cycles > max ? cycles : max;
+			sum += cycles;
+		}
+	}
+	printf("%d,%ld,%ld,%ld\n", contenders, min, sum / (ROUNDS * ITERATIONS), max);
+}
+
+// Measure the latency in cycles of a yield, a trap and a full scheduling decision
+void measure_sched(void)
+{
+	uint64_t min = UINT64_MAX, max = 0, sum = 0;
+
+	for (int r = 0; r < ROUNDS; ++r) {
+		s3k_sleep_until(0); // Synchronize to the next time slot
+		for (int i = 0; i < ITERATIONS; ++i) {
+			uint64_t start = rdcycle();
+			s3k_sync();
+			uint64_t cycles = rdcycle() - start;
+			min = cycles < min ? cycles : min;
+			max = cycles > max ? cycles : max;
+			sum += cycles;
+		}
+	}
+	printf("%ld,%ld,%ld\n", min, sum / (ROUNDS * ITERATIONS), max);
+}
+
+int main(void)
+{
+	s3k_sync();
+	printf("Scheduler latency benchmark\n");
+	printf("min,avg,max\n");
+	measure_sched();
+
+	printf("Lock contention benchmark\n");
+	printf("contenders,min,avg,max\n");
+
+	// Measure without contention, then add one contending hart at a time
+	int contenders = 0;
+	measure(contenders);
+	for (s3k_pid_t pid = 2; pid <= 4; ++pid) {
+		int mon = contender_init(pid);
+		if (mon < 0)
+			break;
+		s3k_mon_resume(mon);
+		measure(++contenders);
+	}
+
+	// Suspend contenders and self
+	for (s3k_pid_t pid = 2; pid < 2 + contenders; ++pid)
+		s3k_mon_suspend((pid - 1) * MONITOR_FUEL);
+	s3k_mon_suspend(0);
+	s3k_sync();
+}
@@ -0,0 +1,12 @@
+#include "s3k.h"
+
+// Contender loop for the lock benchmark.
+// Keeps the kernel lock busy from another hart.
+int main(void)
+{
+	s3k_cap_mem_t cap;
+
+	while (1) {
+		s3k_mem_get(0, &cap);
+	}
+}